@@ -0,0 +1,188 @@
+import { pathToFileURL } from 'url';
+
+/**
+ * Generates large synthetic C translation units (.cup) for benchmarking upp.
+ *
+ * Usage:
+ *   node bench/generate.ts --lines=100000 [--features=defer:1,method:1,lambda:1,managed:1,trace:1,plain:4] > big.cup
+ *
+ * Each feature contributes self-contained blocks of code; the weights control how
+ * often each block appears. Names are suffixed with a counter so every block is unique.
+ */
+
+export const FEATURES = ['plain', 'defer', 'method', 'lambda', 'managed', 'trace'] as const;
+export type Feature = typeof FEATURES[number];
+
+export const DEFAULT_MIX: Record<Feature, number> = {
+    plain: 4,
+    defer: 1,
+    method: 1,
+    lambda: 1,
+    managed: 1,
+    trace: 1
+};
+
+const INCLUDES: Partial<Record<Feature, string>> = {
+    defer: '@include(defer.hup)',
+    method: '@include(method.hup)',
+    lambda: '@include(lambda.hup)',
+    managed: '@include(managed-struct.hup)',
+    trace: '@include(trace.hup)'
+};
+
+/** Entry point of each block, called from main() so the generated program is complete. */
+const CALLS: Record<Feature, (k: number) => string> = {
+    plain: (k) => `plain_${k}(${k % 7}, 3)`,
+    defer: (k) => `defer_${k}(${k % 13})`,
+    method: (k) => `method_${k}()`,
+    lambda: (k) => `lambda_${k}(${k % 5})`,
+    managed: (k) => `managed_${k}(${k % 11})`,
+    trace: (k) => `traced_${k}(${k % 3})`
+};
+
+const BLOCKS: Record<Feature, (k: number) => string> = {
+    plain: (k) => `
+static int plain_${k}(int a, int b) {
+    int s = 0;
+    for (int i = 0; i < a; i++) {
+        if (i % 3 == 0) s += i * b;
+        else s -= b;
+    }
+    return s;
+}
+`,
+    defer: (k) => `
+int defer_${k}(int n) {
+    char *buf = malloc(n + 1);
+    @defer free(buf);
+    for (int i = 0; i < n; i++) buf[i] = (char)('a' + i % 26);
+    buf[n] = 0;
+    if (n > 10) return n;
+    return (int)strlen(buf);
+}
+`,
+    method: (k) => `
+typedef struct Counter_${k} { int value; } Counter_${k};
+
+@method(Counter_${k}) int bump(Counter_${k} *c, int by) {
+    c->value += by;
+    return c->value;
+}
+
+int method_${k}(void) {
+    Counter_${k} c = { 0 };
+    c.bump(1);
+    return c.bump(2);
+}
+`,
+    lambda: (k) => `
+int lambda_${k}(int base) {
+    int total = 0;
+    @lambda void add(int v) {
+        total += v + base;
+    }
+    for (int i = 0; i < 4; i++) add(i);
+    return total;
+}
+`,
+    managed: (k) => `
+typedef struct Node_${k} { int v; int w; } Node_${k};
+@ManagedStruct(Node_${k}) NodeRef_${k};
+
+int managed_${k}(int v) {
+    NodeRef_${k} a;
+    a->v = v;
+    NodeRef_${k} b = a;
+    b->w = v * 2;
+    return b->v + a->w;
+}
+`,
+    trace: (k) => `
+@trace int traced_${k}(int x) {
+    int y = x * 2;
+    return y + ${k};
+}
+`
+};
+
+/**
+ * Parses a feature mix such as "defer:2,lambda" (weight defaults to 1).
+ * @param {string} spec - Comma separated feature[:weight] list.
+ * @returns {Record<Feature, number>}
+ */
+export function parseMix(spec: string): Record<Feature, number> {
+    const mix = Object.fromEntries(FEATURES.map(f => [f, 0])) as Record<Feature, number>;
+    for (const part of spec.split(',').map(s => s.trim()).filter(Boolean)) {
+        const [name, weight] = part.split(':');
+        if (!(FEATURES as readonly string[]).includes(name)) {
+            throw new Error(`Unknown feature '${name}'. Expected one of ${FEATURES.join(', ')}`);
+        }
+        mix[name as Feature] = weight === undefined ? 1 : Number(weight);
+    }
+    return mix;
+}
+
+/**
+ * Builds a translation unit of at least `lines` lines.
+ * @param {number} lines - Target line count.
+ * @param {Record<Feature, number>} [mix] - Relative weight of each feature block.
+ * @returns {string} The .cup source.
+ */
+export function generateTranslationUnit(lines: number, mix: Record<Feature, number> = DEFAULT_MIX): string {
+    const enabled = FEATURES.filter(f => mix[f] > 0);
+    if (enabled.length === 0) throw new Error('generateTranslationUnit: no features enabled');
+
+    // Expand weights into a round-robin schedule, e.g. plain x4, defer x1, ...
+    const schedule: Feature[] = [];
+    for (const f of enabled) {
+        for (let i = 0; i < mix[f]; i++) schedule.push(f);
+    }
+
+    const header = [
+        '#include <stdlib.h>',
+        '#include <string.h>',
+        '#include <stdio.h>',
+        ...enabled.map(f => INCLUDES[f]).filter(Boolean),
+        ''
+    ].join('\n');
+
+    const parts: string[] = [header];
+    const calls: string[] = [];
+    let count = header.split('\n').length;
+    for (let k = 0; count < lines; k++) {
+        const feature = schedule[k % schedule.length];
+        const block = BLOCKS[feature](k);
+        parts.push(block);
+        count += block.split('\n').length - 1;
+        if (calls.length < 64) calls.push(`    r += ${CALLS[feature](k)};`);
+    }
+
+    parts.push(`
+int main(void) {
+    int r = 0;
+${calls.join('\n')}
+    printf("%d\\n", r);
+    return 0;
+}
+`);
+    return parts.join('');
+}
+
+/**
+ * Parses a size such as "10k", "100k" or "1m".
+ * @param {string} spec
+ * @returns {number}
+ */
+export function parseSize(spec: string): number {
+    const m = spec.trim().toLowerCase().match(/^(\d+(?:\.\d+)?)([km]?)$/);
+    if (!m) throw new Error(`Invalid size '${spec}'`);
+    const scale = m[2] === 'k' ? 1e3 : m[2] === 'm' ? 1e6 : 1;
+    return Math.round(Number(m[1]) * scale);
+}
+
+if (import.meta.url === pathToFileURL(process.argv[1]).href) {
+    const arg = (name: string) => process.argv.find(a => a.startsWith(`--${name}=`))?.split('=')[1];
+    const lines = parseSize(arg('lines') ?? '10k');
+    const mix = arg('features') ? parseMix(arg('features')!) : DEFAULT_MIX;
+    process.stdout.write(generateTranslationUnit(lines, mix));
+}
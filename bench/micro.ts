@@ -0,0 +1,215 @@
+import fs from 'fs';
+import v8 from 'v8';
+import path from 'path';
+import { spawnSync } from 'child_process';
+import { performance } from 'perf_hooks';
+import { Registry } from '../src/registry.ts';
+import { SourceTree, SourceNode } from '../src/source_tree.ts';
+import { UppHelpersC } from '../src/upp_helpers_c.ts';
+import { Transformer } from '../src/transformer.ts';
+import { DiagnosticsManager } from '../src/diagnostics.ts';
+import { generateTranslationUnit } from './generate.ts';
+
+/**
+ * Micro-benchmarks for the engine primitives the transformer is built on.
+ *
+ * Usage:
+ *   npm run bench:micro [-- --filter=edit] [--time=1000] [--json=out.json]
+ *
+ * Each case reports ops/sec, mean time per op, and bytes allocated per op. Allocation
+ * is the growth in used heap across a batch plus everything the collector reclaimed
+ * during it (from v8.GCProfiler), measured after a forced gc(). That needs
+ * --expose-gc, so the script re-runs itself with the flag if it is missing.
+ */
+
+if (typeof globalThis.gc !== 'function') {
+    const child = spawnSync(process.execPath, [...process.execArgv, '--expose-gc', ...process.argv.slice(1)], { stdio: 'inherit' });
+    process.exit(child.status ?? 1);
+}
+const gc = globalThis.gc as () => void;
+
+interface MicroCase<S> {
+    name: string;
+    /** Creates the per-op inputs for a batch of `n` ops. Not timed. */
+    prepare?: (n: number) => S[];
+    run: (state: S) => unknown;
+}
+
+interface MicroResult {
+    name: string;
+    ops: number;
+    opsPerSec: number;
+    nsPerOp: number;
+    bytesPerOp: number;
+    gcs: number;
+}
+
+const arg = (name: string) => process.argv.find(a => a.startsWith(`--${name}=`))?.split('=')[1];
+const filter = arg('filter') ? new RegExp(arg('filter')!) : null;
+const minTime = Number(arg('time') ?? 1000);
+
+/**
+ * Runs a case in growing batches until `minTime` ms of timed work has been done.
+ * @param {MicroCase<S>} c - The case to run.
+ * @returns {MicroResult}
+ */
+function measure<S>(c: MicroCase<S>): MicroResult {
+    let batch = 1;
+    let ops = 0, elapsed = 0, allocated = 0, gcs = 0;
+
+    // Warm up so the batches measure optimised code
+    for (const s of c.prepare ? c.prepare(8) : new Array(8).fill(undefined)) c.run(s);
+
+    while (elapsed < minTime) {
+        const states = c.prepare ? c.prepare(batch) : new Array(batch).fill(undefined);
+        gc();
+        const profiler = new v8.GCProfiler();
+        const heapBefore = process.memoryUsage().heapUsed;
+        profiler.start();
+        const t0 = performance.now();
+        for (let i = 0; i < batch; i++) c.run(states[i]);
+        const t1 = performance.now();
+        const heapAfter = process.memoryUsage().heapUsed;
+        const gcStats = profiler.stop();
+
+        let reclaimed = 0;
+        for (const s of gcStats?.statistics ?? []) {
+            reclaimed += s.beforeGC.heapStatistics.usedHeapSize - s.afterGC.heapStatistics.usedHeapSize;
+        }
+        allocated += heapAfter - heapBefore + reclaimed;
+        gcs += gcStats?.statistics.length ?? 0;
+        ops += batch;
+        elapsed += t1 - t0;
+        if (t1 - t0 < 50) batch *= 2;
+    }
+
+    return {
+        name: c.name,
+        ops,
+        opsPerSec: ops / (elapsed / 1000),
+        nsPerOp: (elapsed * 1e6) / ops,
+        bytesPerOp: Math.max(0, allocated / ops),
+        gcs
+    };
+}
+
+// Fixtures
+
+const projectRoot = path.resolve(path.dirname(new URL(import.meta.url).pathname), '..');
+const registry = new Registry({ stdPath: path.join(projectRoot, 'std'), diagnostics: new DiagnosticsManager({}), onMaterialize: () => { } });
+const language = registry.language;
+
+const largeSource = generateTranslationUnit(10000, { plain: 1, defer: 0, method: 0, lambda: 0, managed: 0, trace: 0 });
+registry.tree = new SourceTree<any>(largeSource, language);
+const helpers = new UppHelpersC(registry, null);
+registry.helpers = helpers as any;
+
+/** A function body with `n` independent statements. */
+const statements = (n: number) => `void f(int x) {\n${Array.from({ length: n }, (_, i) => `    x = x + ${i};`).join('\n')}\n}\n`;
+
+/** Creates `n` statement nodes spread over trees of at most 500 statements each. */
+function statementNodes(n: number): SourceNode<any>[] {
+    const nodes: SourceNode<any>[] = [];
+    while (nodes.length < n) {
+        const count = Math.min(500, n - nodes.length);
+        const tree = new SourceTree<any>(statements(count), language);
+        nodes.push(...tree.root.find('expression_statement'));
+    }
+    return nodes;
+}
+
+/** A function whose use of `target` sits `depth` compound statements below its declaration. */
+function nestedUse(depth: number): SourceNode<any> {
+    const open = Array.from({ length: depth }, (_, i) => `${'    '.repeat(i + 1)}{ int pad${i} = ${i};`).join('\n');
+    const close = '}'.repeat(depth);
+    const tree = new SourceTree<any>(`int g(void) {\n    int target = 0;\n${open}\n target = 1; ${close}\n    return target;\n}\n`, language);
+    return tree.root.find((n: SourceNode<any>) => n.type === 'identifier' && n.text === 'target')[1];
+}
+
+const smallFn = new SourceTree<any>('int add(int a) { return a; }', language).root.find('function_definition')[0];
+const bigFn = new SourceTree<any>(statements(50), language).root.find('function_definition')[0];
+const depths = [1, 8, 32].map(d => [d, nestedUse(d)] as const);
+const walkTree = new SourceTree<any>(largeSource, language);
+
+const cases: MicroCase<any>[] = [
+    {
+        name: `SourceTree.edit (10k lines, ${registry.tree.nodeCache.size} nodes)`,
+        prepare: (n) => Array.from({ length: n }, (_, i) => i),
+        run: (i: number) => i % 2 === 0 ? registry.tree!.edit(0, 0, ' ') : registry.tree!.edit(0, 1, '')
+    },
+    {
+        name: 'SourceNode.remove',
+        prepare: statementNodes,
+        run: (node: SourceNode<any>) => node.remove()
+    },
+    {
+        name: 'SourceNode.replaceWith(string)',
+        prepare: statementNodes,
+        run: (node: SourceNode<any>) => node.replaceWith('x = 0;')
+    },
+    {
+        name: 'SourceTree.fragment (identifier)',
+        run: () => SourceTree.fragment('value', language)
+    },
+    {
+        name: 'SourceTree.fragment (statement)',
+        run: () => SourceTree.fragment('if (a > b) { a = b; } else { b = a; }', language)
+    },
+    {
+        name: 'SourceTree.fragment (50-line function)',
+        run: () => SourceTree.fragment(statements(50), language)
+    },
+    {
+        name: 'PatternMatcher.match',
+        run: () => helpers.matcher.match(smallFn, 'int $name(int $p) { return $r; }')
+    },
+    {
+        name: 'PatternMatcher.match (__until, 50 statements)',
+        run: () => helpers.matcher.match(bigFn, '$returnType $name($params__until) { $body__until }')
+    },
+    {
+        name: 'upp.code (0 interpolations)',
+        run: () => helpers.code`int x = 1;`
+    },
+    {
+        name: 'upp.code (1 interpolation)',
+        prepare: (n) => statementNodes(n),
+        run: (node: SourceNode<any>) => helpers.code`if (ready) { ${node} }`
+    },
+    {
+        name: 'upp.code (8 interpolations)',
+        prepare: (n) => {
+            const nodes = statementNodes(n * 8);
+            return Array.from({ length: n }, (_, i) => nodes.slice(i * 8, i * 8 + 8));
+        },
+        run: (n: SourceNode<any>[]) => helpers.code`{ ${n[0]} ${n[1]} ${n[2]} ${n[3]} ${n[4]} ${n[5]} ${n[6]} ${n[7]} }`
+    },
+    ...depths.map(([depth, id]) => ({
+        name: `findDefinitionOrNull (depth ${depth})`,
+        run: () => helpers.findDefinitionOrNull(id)
+    })),
+    {
+        name: `Transformer.walk (10k lines, unmodified)`,
+        run: () => {
+            const it = (new Transformer(registry) as any).walk(walkTree.root, new WeakSet());
+            let visits = 0;
+            while (!it.next().done) visits++;
+            return visits;
+        }
+    }
+];
+
+const results: MicroResult[] = [];
+const pad = (s: string | number, n: number) => String(s).padStart(n);
+console.log(`${'case'.padEnd(48)} ${pad('ops/s', 12)} ${pad('µs/op', 10)} ${pad('bytes/op', 12)} ${pad('gcs', 6)}`);
+for (const c of cases) {
+    if (filter && !filter.test(c.name)) continue;
+    const r = measure(c);
+    results.push(r);
+    console.log(`${r.name.padEnd(48)} ${pad(r.opsPerSec.toFixed(0), 12)} ${pad((r.nsPerOp / 1000).toFixed(2), 10)} ${pad(r.bytesPerOp.toFixed(0), 12)} ${pad(r.gcs, 6)}`);
+}
+
+const jsonPath = arg('json');
+if (jsonPath) {
+    fs.writeFileSync(jsonPath, JSON.stringify({ date: new Date().toISOString(), node: process.version, results }, null, 2));
+}
@@ -0,0 +1,115 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { spawnSync, execSync } from 'child_process';
+import { generateTranslationUnit, parseMix, parseSize, DEFAULT_MIX } from './generate.ts';
+
+/**
+ * Macro-benchmark harness. Generates synthetic translation units of each requested
+ * size, transforms each in a fresh worker process and records throughput, peak RSS
+ * and per-phase time as JSON under bench/results/.
+ *
+ * Usage:
+ *   npm run bench [-- --sizes=10k,100k,1m] [--features=defer:1,plain:4] [--out=file.json] [--compare=prev.json]
+ */
+
+interface BenchResult {
+    size: string;
+    lines: number;
+    ms: number;
+    linesPerSec: number;
+    outputBytes: number;
+    maxRSSKiB: number;
+    phases: Record<string, number>;
+    stats: Record<string, any>;
+}
+
+const benchDir = path.dirname(new URL(import.meta.url).pathname);
+const arg = (name: string) => process.argv.find(a => a.startsWith(`--${name}=`))?.split('=')[1];
+
+const sizes = (arg('sizes') ?? '10k,100k,1m').split(',').map(s => s.trim()).filter(Boolean);
+const features = arg('features');
+const mix = features ? parseMix(features) : DEFAULT_MIX;
+
+function gitRevision(): string {
+    try {
+        return execSync('git rev-parse --short HEAD', { cwd: benchDir, encoding: 'utf8', stdio: ['ignore', 'pipe', 'ignore'] }).trim();
+    } catch {
+        return 'unknown';
+    }
+}
+
+const workDir = fs.mkdtempSync(path.join(os.tmpdir(), 'upp-bench-'));
+const results: BenchResult[] = [];
+
+try {
+    for (const size of sizes) {
+        const file = path.join(workDir, `bench_${size}.cup`);
+        fs.writeFileSync(file, generateTranslationUnit(parseSize(size), mix));
+
+        process.stderr.write(`[bench] ${size}... `);
+        const child = spawnSync(process.execPath, [
+            ...process.execArgv,
+            '--max-old-space-size=8192',
+            path.join(benchDir, 'worker.ts'),
+            file
+        ], { encoding: 'utf8', maxBuffer: 64 * 1024 * 1024 });
+
+        if (child.status !== 0) {
+            process.stderr.write('failed\n');
+            console.error(child.stderr);
+            process.exit(1);
+        }
+
+        const r = JSON.parse(child.stdout.trim().split('\n').pop()!);
+        const result: BenchResult = {
+            size,
+            lines: r.lines,
+            ms: r.ms,
+            linesPerSec: r.lines / (r.ms / 1000),
+            outputBytes: r.outputBytes,
+            maxRSSKiB: r.maxRSSKiB,
+            phases: r.phases,
+            stats: r.stats
+        };
+        results.push(result);
+        process.stderr.write(`${(result.ms / 1000).toFixed(2)}s\n`);
+    }
+} finally {
+    fs.rmSync(workDir, { recursive: true, force: true });
+}
+
+const revision = gitRevision();
+const report = {
+    date: new Date().toISOString(),
+    revision,
+    node: process.version,
+    platform: `${os.platform()}-${os.arch()}`,
+    mix,
+    results
+};
+
+// Text summary
+const pad = (s: string | number, n: number) => String(s).padStart(n);
+console.log(`${pad('size', 6)} ${pad('lines', 9)} ${pad('time s', 9)} ${pad('lines/s', 10)} ${pad('RSS MiB', 9)}  phases (self ms)`);
+for (const r of results) {
+    const phases = Object.entries(r.phases).sort((a, b) => b[1] - a[1]).map(([k, v]) => `${k}=${v.toFixed(0)}`).join(' ');
+    console.log(`${pad(r.size, 6)} ${pad(r.lines, 9)} ${pad((r.ms / 1000).toFixed(2), 9)} ${pad(r.linesPerSec.toFixed(0), 10)} ${pad((r.maxRSSKiB / 1024).toFixed(0), 9)}  ${phases}`);
+}
+
+const compare = arg('compare');
+if (compare) {
+    const previous = JSON.parse(fs.readFileSync(compare, 'utf8'));
+    const delta = (now: number, then: number) => `${now >= then ? '+' : ''}${(((now - then) / then) * 100).toFixed(1)}%`;
+    console.log(`\nCompared with ${previous.revision} (${previous.date}):`);
+    for (const r of results) {
+        const p = (previous.results as BenchResult[]).find(x => x.size === r.size);
+        if (!p) continue;
+        console.log(`${pad(r.size, 6)}  time ${delta(r.ms, p.ms)}  lines/s ${delta(r.linesPerSec, p.linesPerSec)}  RSS ${delta(r.maxRSSKiB, p.maxRSSKiB)}`);
+    }
+}
+
+const outPath = arg('out') ?? path.join(benchDir, 'results', `${report.date.slice(0, 10)}-${revision}.json`);
+fs.mkdirSync(path.dirname(outPath), { recursive: true });
+fs.writeFileSync(outPath, JSON.stringify(report, null, 2));
+console.log(`\n[bench] results written to ${path.relative(process.cwd(), outPath)}`);
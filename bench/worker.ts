@@ -0,0 +1,58 @@
+import fs from 'fs';
+import path from 'path';
+import { performance } from 'perf_hooks';
+import { Registry } from '../src/registry.ts';
+import { DependencyCache } from '../src/dependency_cache.ts';
+import { DiagnosticsManager } from '../src/diagnostics.ts';
+import { Profiler } from '../src/profiler.ts';
+import { TransformStats } from '../src/stats.ts';
+
+/**
+ * Transforms a single file and prints one JSON result line to stdout.
+ * Run in a fresh process per input by bench/run.ts so that peak RSS is per-file.
+ *
+ * Usage: node bench/worker.ts <file.cup>
+ *
+ * The C preprocessor is not run: the generated units only use #include for system
+ * headers, which tree-sitter parses as opaque directives, so the measurement is of
+ * upp itself.
+ */
+
+const file = path.resolve(process.argv[2]);
+const projectRoot = path.resolve(path.dirname(new URL(import.meta.url).pathname), '..');
+const stdPath = path.join(projectRoot, 'std');
+
+// Phase timings only: per-macro and per-rule spans would dominate the run at this scale.
+const profiler = new Profiler({ minEventMicros: Infinity, categories: ['registry', 'tree-sitter'] });
+Profiler.active = profiler;
+
+const stats = new TransformStats();
+const source = fs.readFileSync(file, 'utf8');
+
+const start = performance.now();
+const registry = new Registry({
+    includePaths: [path.dirname(file), stdPath, projectRoot],
+    stdPath,
+    cache: new DependencyCache(),
+    diagnostics: new DiagnosticsManager({}),
+    onMaterialize: () => { },
+    stats
+});
+const output = registry.transform(source, file);
+const ms = performance.now() - start;
+
+const phases: Record<string, number> = {};
+for (const t of profiler.totals.values()) {
+    phases[`${t.cat}:${t.name}`] = Math.round(t.self) / 1000;
+}
+
+process.stdout.write(JSON.stringify({
+    file,
+    lines: source.split('\n').length,
+    ms,
+    outputBytes: output.length,
+    // maxRSS is reported in KiB
+    maxRSSKiB: process.resourceUsage().maxRSS,
+    phases,
+    stats
+}) + '\n');
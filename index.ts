@@ -9,6 +9,10 @@ import { DependencyCache } from './src/dependency_cache.ts';
 import { DiagnosticsManager } from './src/diagnostics.ts';
 import { parseArgs } from './src/cli.ts';
 import { resolveConfig } from './src/config_loader.ts';
+import { Profiler } from './src/profiler.ts';
+import { TransformStats } from './src/stats.ts';
+import { MemoryReport } from './src/mem_report.ts';
+import { FileLookupCache } from './src/fs_lookup.ts';
 import type { CompilerCommand, SourceInfo } from './src/cli.ts';
 
 const command: CompilerCommand = parseArgs(process.argv.slice(2));
@@ -22,10 +26,45 @@ if (!command.isUppCommand) {
     process.exit(1);
 }
 
+if (command.profile) {
+    const profiler = new Profiler();
+    Profiler.active = profiler;
+    process.on('exit', () => {
+        profiler.write(command.profile!);
+        console.error(profiler.summary(command.profileTop));
+        console.error(`[upp] profile written to ${command.profile}`);
+    });
+}
+
+// Counters are accumulated across every file in this invocation, when requested
+const stats = command.stats ? new TransformStats() : undefined;
+if (stats) {
+    process.on('exit', () => {
+        if (command.stats === true) console.error(stats.format());
+        else fs.writeFileSync(command.stats as string, JSON.stringify(stats, null, 2));
+    });
+}
+
+if (command.memReport) {
+    const memReport = new MemoryReport({ snapshotThreshold: command.memSnapshotAt ? command.memSnapshotAt * 1024 * 1024 : undefined });
+    MemoryReport.active = memReport;
+    process.on('exit', () => {
+        if (command.memReport === true) console.error(memReport.format());
+        else fs.writeFileSync(command.memReport!, JSON.stringify(memReport, null, 2));
+    });
+}
+
 // Global state across transpilations
 const projectRoot = path.dirname(new URL(import.meta.url).pathname);
 const stdPath = path.join(projectRoot, 'std');
 const cache = new DependencyCache();
+// One diagnostics sink for the whole invocation, so json/sarif output covers every file
+const diagnostics = new DiagnosticsManager({
+    format: command.diagnosticsFormat || (command.diagnosticsOutput ? 'json' : 'text'),
+    output: command.diagnosticsOutput
+});
+process.on('exit', () => diagnostics.flush());
+const fileLookup = new FileLookupCache();
 let extraDeps: string[] = []; // Collected from -M flags during preprocessing
 
 function preprocess(filePath: string, extraFlags: string[] = [], includePaths: string[] = []): string {
@@ -34,7 +73,7 @@ function preprocess(filePath: string, extraFlags: string[] = [], includePaths: s
     const flags = [...extraFlags, '-E', '-P', '-C', '-x', 'c'].join(' ');
     try {
         const cmd = `${compiler} ${flags} ${iFlags} "${filePath}"`;
-        return execSync(cmd, { encoding: 'utf8', stdio: ['pipe', 'pipe', 'pipe'] });
+        return Profiler.measure('preprocess', 'cc', () => execSync(cmd, { encoding: 'utf8', stdio: ['pipe', 'pipe', 'pipe'] }), { file: filePath });
     } catch (e: any) {
         if (e.stderr) {
             console.error(e.stderr.toString());
@@ -67,20 +106,19 @@ function buildRegistry(
 ): Registry {
     const config = {
         cache,
+        fileLookup,
         includePaths: finalIncludePaths,
         stdPath,
-        diagnostics: new DiagnosticsManager({}),
+        diagnostics,
         onMaterialize,
-        preprocess: preprocessFn
+        preprocess: preprocessFn,
+        stats,
+        compact: command.compact || loadedConfig.compact || false
     };
     const registry = new Registry(config);
     const coreFiles = loadedConfig.core || [];
     for (const coreFile of coreFiles) {
-        let foundPath: string | null = null;
-        for (const inc of finalIncludePaths) {
-            const p = path.join(inc, coreFile);
-            if (fs.existsSync(p)) { foundPath = p; break; }
-        }
+        const foundPath = fileLookup.resolve(coreFile, finalIncludePaths);
         if (foundPath) {
             registry.loadDependency(foundPath);
         } else {
@@ -146,7 +184,7 @@ if (command.mode === 'transpile' || command.mode === 'ast' || command.mode === '
         if (command.mode === 'ast') {
             const absSource = path.resolve(expandedFiles[0]);
             const preProcessed = preprocess(absSource, command.depFlags || [], command.includePaths || []);
-            const registry = new Registry({ diagnostics: new DiagnosticsManager({}) });
+            const registry = new Registry({ diagnostics, stats });
             const tree = registry.parser.parse(preProcessed);
             console.log(tree.rootNode.toString());
             process.exit(0);
@@ -157,7 +195,9 @@ if (command.mode === 'transpile' || command.mode === 'ast' || command.mode === '
         for (const absSource of expandedFiles) {
             const { finalIncludePaths, loadedConfig } = resolveFinalIncludePaths(absSource);
             const preProcessed = preprocess(absSource, command.depFlags || [], finalIncludePaths);
+            MemoryReport.active?.sample(`preprocess ${path.basename(absSource)}`);
             const onMaterialize = makeMaterializationHandler(materializations, authoritativeMaterials);
+            const transformStart = performance.now();
             const registry = buildRegistry(
                 finalIncludePaths,
                 loadedConfig,
@@ -166,6 +206,8 @@ if (command.mode === 'transpile' || command.mode === 'ast' || command.mode === '
             );
 
             const output = registry.transform(preProcessed, absSource);
+            if (stats) stats.transformMs += performance.now() - transformStart;
+            if (MemoryReport.active) await MemoryReport.active.settle(`settled ${path.basename(absSource)}`);
 
             let mainOutputPath: string | null = null;
             if (absSource.endsWith('.cup')) mainOutputPath = absSource.slice(0, -4) + '.c';
@@ -288,10 +330,14 @@ if (command.sources) {
                 };
 
                 const preProcessed = preprocess(source.cupFile, command.depFlags, finalIncludePaths);
+                MemoryReport.active?.sample(`preprocess ${path.basename(source.cupFile)}`);
                 const onMaterialize = makeMaterializationHandler(materializations, authoritativeMaterials, /* writeThrough */ true);
+                const transformStart = performance.now();
                 const registry = buildRegistry(finalIncludePaths, loadedConfig, onMaterialize, preprocessFn);
 
                 const output = registry.transform(preProcessed, source.absCupFile);
+                if (stats) stats.transformMs += performance.now() - transformStart;
+                if (MemoryReport.active) await MemoryReport.active.settle(`settled ${path.basename(source.absCupFile)}`);
 
                 // Write output to the .c file
                 fs.writeFileSync(source.absCFile, output);
@@ -0,0 +1,623 @@
+import type { SourceNode } from './source_tree.ts';
+
+/** An arithmetic C type. Integers carry their width and signedness; `name` is used when printing literals. */
+export interface ScalarType {
+    kind: 'int' | 'float';
+    bits: number;
+    signed: boolean;
+    name: string;
+}
+
+interface ArrayType {
+    kind: 'array';
+    element: CType;
+    length: number;
+}
+
+type CType = ScalarType | ArrayType;
+
+/** Integers are held as BigInt so 64-bit arithmetic is exact; floats as numbers. */
+interface Scalar {
+    type: ScalarType;
+    value: bigint | number;
+}
+
+interface ArrayValue {
+    type: ArrayType;
+    elements: Value[];
+}
+
+type Value = Scalar | ArrayValue;
+
+interface LValue {
+    get(): Value;
+    set(value: Value): void;
+}
+
+type Completion = { kind: 'break' } | { kind: 'continue' } | { kind: 'return'; value: Scalar | null } | undefined;
+
+export interface CInterpreterOptions {
+    /** Returns the function_definition called by `name` at `callSite`, or null if there is none to evaluate. */
+    resolveFunction: (name: string, callSite: SourceNode<any>) => SourceNode<any> | null;
+    /** Statements and expressions evaluated before giving up. */
+    stepLimit?: number;
+}
+
+/**
+ * Thrown for anything that cannot be evaluated at transpile time: unsupported
+ * syntax, non-constant inputs, undefined behaviour or an exhausted step budget.
+ * Callers keep the runtime call instead.
+ */
+export class ConstEvalError extends Error { }
+
+const int = (bits: number, signed: boolean, name: string): ScalarType => ({ kind: 'int', bits, signed, name });
+const INT = int(32, true, 'int');
+const UINT = int(32, false, 'unsigned int');
+const LONG = int(64, true, 'long');
+const ULONG = int(64, false, 'unsigned long');
+const BOOL = int(1, false, '_Bool');
+const FLOAT: ScalarType = { kind: 'float', bits: 32, signed: true, name: 'float' };
+const DOUBLE: ScalarType = { kind: 'float', bits: 64, signed: true, name: 'double' };
+
+// LP64 sizes, the same assumption @packed_order makes
+const SCALAR_TYPES: Record<string, ScalarType> = {
+    'char': int(8, true, 'char'), 'signed char': int(8, true, 'signed char'), 'unsigned char': int(8, false, 'unsigned char'),
+    'short': int(16, true, 'short'), 'short int': int(16, true, 'short'), 'signed short': int(16, true, 'short'),
+    'unsigned short': int(16, false, 'unsigned short'), 'unsigned short int': int(16, false, 'unsigned short'),
+    'int': INT, 'signed': INT, 'signed int': INT, 'unsigned': UINT, 'unsigned int': UINT,
+    'long': LONG, 'long int': LONG, 'signed long': LONG, 'unsigned long': ULONG, 'unsigned long int': ULONG,
+    'long long': int(64, true, 'long long'), 'long long int': int(64, true, 'long long'),
+    'unsigned long long': int(64, false, 'unsigned long long'), 'unsigned long long int': int(64, false, 'unsigned long long'),
+    '_Bool': BOOL, 'bool': BOOL,
+    'int8_t': int(8, true, 'int8_t'), 'uint8_t': int(8, false, 'uint8_t'),
+    'int16_t': int(16, true, 'int16_t'), 'uint16_t': int(16, false, 'uint16_t'),
+    'int32_t': INT, 'uint32_t': UINT, 'int64_t': LONG, 'uint64_t': ULONG,
+    'size_t': ULONG, 'ptrdiff_t': LONG, 'intptr_t': LONG, 'uintptr_t': ULONG,
+    'float': FLOAT, 'double': DOUBLE
+};
+
+/**
+ * Evaluates calls of pure C functions over the SourceNode tree: integer and
+ * floating-point arithmetic, local scalars and arrays, and structured control
+ * flow. Integers follow C's conversions on an LP64 target; signed overflow,
+ * division by zero and out-of-range indexing are refused rather than folded.
+ */
+export class CInterpreter {
+    private steps = 0;
+    private depth = 0;
+    private readonly stepLimit: number;
+    private readonly options: CInterpreterOptions;
+
+    constructor(options: CInterpreterOptions) {
+        this.options = options;
+        this.stepLimit = options.stepLimit ?? 1_000_000;
+    }
+
+    /**
+     * Evaluates `fn(args...)`, where each argument must be a constant expression.
+     * @param {SourceNode<any>} fn - The function_definition to call.
+     * @param {SourceNode<any>[]} args - The argument expressions.
+     * @returns {string} The result as a C literal of the function's return type.
+     */
+    evaluateCall(fn: SourceNode<any>, args: SourceNode<any>[]): string {
+        const values = args.map(arg => this.scalar(this.evaluate(arg, new Scope(null))));
+        return formatLiteral(this.call(fn, values));
+    }
+
+    private fail(node: SourceNode<any> | null, message: string): never {
+        throw new ConstEvalError(node ? `${message}: ${node.text.slice(0, 40)}` : message);
+    }
+
+    private step(node: SourceNode<any>): void {
+        if (++this.steps > this.stepLimit) this.fail(node, `Step limit of ${this.stepLimit} exceeded`);
+    }
+
+    private call(fn: SourceNode<any>, args: Scalar[]): Scalar {
+        const declarator = fn.named.declarator;
+        if (declarator?.type !== 'function_declarator') this.fail(fn, 'Only functions returning arithmetic types can be evaluated');
+        const returnType = this.parseType(fn.named.type!);
+        const params = declarator.named.parameters!.children.filter(c => c.type === 'parameter_declaration');
+        const named = params.filter(p => p.named.declarator);
+        if (named.length !== args.length) this.fail(fn, `Expected ${named.length} arguments, got ${args.length}`);
+        if (++this.depth > 256) this.fail(fn, 'Recursion too deep');
+
+        const scope = new Scope(null);
+        named.forEach((param, i) => {
+            if (param.named.declarator!.type !== 'identifier') this.fail(param, 'Only scalar parameters are supported');
+            const type = this.parseType(param.named.type!);
+            scope.declare(param.named.declarator!.text, this.convert(args[i], type));
+        });
+        const completion = this.execute(fn.named.body!, scope);
+        this.depth--;
+        if (completion?.kind !== 'return' || !completion.value) this.fail(fn, 'Function ended without returning a value');
+        return this.convert(completion.value, returnType);
+    }
+
+    private parseType(node: SourceNode<any>): ScalarType {
+        const type = SCALAR_TYPES[node.text.replace(/\s+/g, ' ').trim()];
+        if (!type) this.fail(node, 'Unsupported type');
+        return type;
+    }
+
+    // Statements
+
+    private execute(node: SourceNode<any>, scope: Scope): Completion {
+        this.step(node);
+        switch (node.type) {
+            case 'compound_statement': {
+                const inner = new Scope(scope);
+                for (const child of node.children) {
+                    if (!child.isNamed || child.type === 'comment') continue;
+                    const completion = this.execute(child, inner);
+                    if (completion) return completion;
+                }
+                return undefined;
+            }
+            case 'declaration':
+                this.declareLocals(node, scope);
+                return undefined;
+            case 'expression_statement': {
+                const expr = node.namedChild(0);
+                if (expr) this.evaluate(expr, scope);
+                return undefined;
+            }
+            case 'if_statement': {
+                const branch = this.truthy(this.evaluate(node.named.condition!, scope)) ? node.named.consequence : node.named.alternative;
+                if (!branch) return undefined;
+                return this.execute(branch.type === 'else_clause' ? branch.namedChild(0)! : branch, scope);
+            }
+            case 'while_statement':
+            case 'do_statement':
+            case 'for_statement':
+                return this.loop(node, scope);
+            case 'return_statement': {
+                const expr = node.namedChild(0);
+                return { kind: 'return', value: expr ? this.scalar(this.evaluate(expr, scope)) : null };
+            }
+            case 'break_statement':
+                return { kind: 'break' };
+            case 'continue_statement':
+                return { kind: 'continue' };
+            default:
+                return this.fail(node, `Unsupported statement '${node.type}'`);
+        }
+    }
+
+    private loop(node: SourceNode<any>, outer: Scope): Completion {
+        const scope = new Scope(outer);
+        const init = node.named.initializer;
+        if (init) {
+            if (init.type === 'declaration') this.declareLocals(init, scope);
+            else this.evaluate(init, scope);
+        }
+        const condition = node.named.condition;
+        const test = () => !condition || this.truthy(this.evaluate(condition, scope));
+        if (node.type !== 'do_statement' && !test()) return undefined;
+        while (true) {
+            const completion = this.execute(node.named.body!, scope);
+            if (completion?.kind === 'break') return undefined;
+            if (completion?.kind === 'return') return completion;
+            if (node.named.update) this.evaluate(node.named.update, scope);
+            if (!test()) return undefined;
+        }
+    }
+
+    private declareLocals(node: SourceNode<any>, scope: Scope): void {
+        if (node.children.some(c => c.type === 'storage_class_specifier')) this.fail(node, 'Static and extern locals are not supported');
+        const base = this.parseType(node.named.type!);
+        for (const declarator of node.children.filter(c => c.fieldName === 'declarator')) {
+            const target = declarator.type === 'init_declarator' ? declarator.named.declarator! : declarator;
+            const value = declarator.type === 'init_declarator' ? declarator.named.value! : null;
+            let type: CType = base;
+            let name = target;
+            const sizes: (SourceNode<any> | undefined)[] = [];
+            while (name.type === 'array_declarator') {
+                sizes.unshift(name.named.size);
+                name = name.named.declarator!;
+            }
+            if (name.type !== 'identifier') this.fail(declarator, 'Only scalar and array locals are supported');
+            for (const size of sizes.reverse()) {
+                const length = size ? Number(this.toInteger(this.evaluate(size, scope), size))
+                    : value?.type === 'initializer_list' ? value.children.filter(c => c.isNamed && c.type !== 'comment').length
+                    : this.fail(declarator, 'Array size is required');
+                type = { kind: 'array', element: type, length };
+            }
+            scope.declare(name.text, value ? this.initialize(type, value, scope) : this.zero(type));
+        }
+    }
+
+    private initialize(type: CType, value: SourceNode<any>, scope: Scope): Value {
+        if (type.kind !== 'array') return this.convert(this.scalar(this.evaluate(value, scope)), type);
+        if (value.type !== 'initializer_list') this.fail(value, 'Arrays must be initialised with a braced list');
+        const items = value.children.filter(c => c.isNamed && c.type !== 'comment');
+        if (items.length > type.length) this.fail(value, 'Too many initialisers');
+        if (items.some(i => i.type === 'initializer_pair')) this.fail(value, 'Designated initialisers are not supported');
+        const array = this.zero(type) as ArrayValue;
+        items.forEach((item, i) => array.elements[i] = this.initialize(type.element, item, scope));
+        return array;
+    }
+
+    private zero(type: CType): Value {
+        if (type.kind === 'array') return { type, elements: Array.from({ length: type.length }, () => this.zero(type.element)) };
+        return { type, value: type.kind === 'int' ? 0n : 0 };
+    }
+
+    // Expressions
+
+    private evaluate(node: SourceNode<any>, scope: Scope): Value {
+        this.step(node);
+        switch (node.type) {
+            case 'number_literal':
+                return parseNumber(node.text) ?? this.fail(node, 'Unsupported number literal');
+            case 'char_literal':
+                return { type: INT, value: BigInt(parseChar(node.text) ?? this.fail(node, 'Unsupported character literal')) };
+            case 'true':
+            case 'false':
+                return { type: INT, value: node.type === 'true' ? 1n : 0n };
+            case 'parenthesized_expression':
+                return this.evaluate(node.namedChild(0)!, scope);
+            case 'identifier':
+            case 'subscript_expression':
+                return this.lvalue(node, scope).get();
+            case 'assignment_expression':
+                return this.assign(node, scope);
+            case 'update_expression': {
+                const target = this.lvalue(node.named.argument!, scope);
+                const before = this.scalar(target.get());
+                const op = node.children.find(c => !c.isNamed)!.text;
+                const after = this.arithmetic(op === '++' ? '+' : '-', before, { type: INT, value: 1n }, node);
+                target.set(this.convert(after, before.type));
+                return node.children[0].isNamed ? before : target.get();
+            }
+            case 'unary_expression':
+                return this.unary(node.children[0].text, this.scalar(this.evaluate(node.named.argument!, scope)), node);
+            case 'binary_expression':
+                return this.binary(node, scope);
+            case 'conditional_expression': {
+                const chosen = this.truthy(this.evaluate(node.named.condition!, scope)) ? node.named.consequence! : node.named.alternative!;
+                const other = chosen === node.named.consequence ? node.named.alternative! : node.named.consequence!;
+                const value = this.scalar(this.evaluate(chosen, scope));
+                // The result has the common type of both arms; only the chosen one is evaluated
+                return this.convert(value, this.commonType(value.type, this.staticType(other, scope)));
+            }
+            case 'comma_expression':
+                this.evaluate(node.named.left!, scope);
+                return this.evaluate(node.named.right!, scope);
+            case 'cast_expression': {
+                const typeNode = node.named.type!;
+                if (typeNode.named.declarator) this.fail(node, 'Only casts to arithmetic types are supported');
+                return this.convert(this.scalar(this.evaluate(node.named.value!, scope)), this.parseType(typeNode.named.type!));
+            }
+            case 'sizeof_expression': {
+                // The operand is not evaluated, so `sizeof(k++)` leaves k alone
+                const typeNode = node.named.type;
+                const type: CType = typeNode ? this.parseType(typeNode.named.type!) : this.objectType(node.named.value!, scope);
+                return { type: ULONG, value: BigInt(sizeOf(type)) };
+            }
+            case 'call_expression': {
+                const callee = node.named.function!;
+                const fn = callee.type === 'identifier' ? this.options.resolveFunction(callee.text, callee) : null;
+                if (!fn) return this.fail(node, 'Only calls to functions defined in this file can be evaluated');
+                const args = node.named.arguments!.children.filter(c => c.isNamed && c.type !== 'comment')
+                    .map(arg => this.scalar(this.evaluate(arg, scope)));
+                return this.call(fn, args);
+            }
+            default:
+                return this.fail(node, `Unsupported expression '${node.type}'`);
+        }
+    }
+
+    /** The type of an expression without evaluating it, keeping array types, for sizeof. */
+    private objectType(node: SourceNode<any>, scope: Scope): CType {
+        switch (node.type) {
+            case 'parenthesized_expression':
+                return this.objectType(node.namedChild(0)!, scope);
+            case 'identifier':
+                return (scope.lookup(node.text) ?? this.fail(node, 'Not a constant')).value.type;
+            case 'subscript_expression': {
+                const array = this.objectType(node.named.argument!, scope);
+                return array.kind === 'array' ? array.element : this.fail(node, 'Subscript of a non-array');
+            }
+            default:
+                return this.staticType(node, scope);
+        }
+    }
+
+    /** The type of an expression without evaluating it, for the arm of `?:` that is not taken. */
+    private staticType(node: SourceNode<any>, scope: Scope): ScalarType {
+        const element = (type: CType): ScalarType => type.kind === 'array' ? element(type.element) : type;
+        switch (node.type) {
+            case 'number_literal':
+                return (parseNumber(node.text) ?? this.fail(node, 'Unsupported number literal')).type;
+            case 'char_literal':
+            case 'true':
+            case 'false':
+                return INT;
+            case 'sizeof_expression':
+                return ULONG;
+            case 'parenthesized_expression':
+                return this.staticType(node.namedChild(0)!, scope);
+            case 'identifier':
+                return element((scope.lookup(node.text) ?? this.fail(node, 'Not a constant')).value.type);
+            case 'subscript_expression':
+                return this.staticType(node.named.argument!, scope);
+            case 'assignment_expression':
+            case 'update_expression':
+                return this.staticType(node.named.left ?? node.named.argument!, scope);
+            case 'comma_expression':
+                return this.staticType(node.named.right!, scope);
+            case 'cast_expression':
+                return this.parseType(node.named.type!.named.type!);
+            case 'unary_expression':
+                return node.children[0].text === '!' ? INT : this.promote(this.staticType(node.named.argument!, scope));
+            case 'conditional_expression':
+                return this.commonType(this.staticType(node.named.consequence!, scope), this.staticType(node.named.alternative!, scope));
+            case 'call_expression': {
+                const callee = node.named.function!;
+                const fn = callee.type === 'identifier' ? this.options.resolveFunction(callee.text, callee) : null;
+                return fn ? this.parseType(fn.named.type!) : this.fail(node, 'Only calls to functions defined in this file can be evaluated');
+            }
+            case 'binary_expression': {
+                const op = node.children[1].text;
+                const left = this.staticType(node.named.left!, scope);
+                if (['==', '!=', '<', '>', '<=', '>=', '&&', '||'].includes(op)) return INT;
+                if (op === '<<' || op === '>>') return this.promote(left);
+                return this.commonType(left, this.staticType(node.named.right!, scope));
+            }
+            default:
+                return this.fail(node, `Unsupported expression '${node.type}'`);
+        }
+    }
+
+    private lvalue(node: SourceNode<any>, scope: Scope): LValue {
+        if (node.type === 'parenthesized_expression') return this.lvalue(node.namedChild(0)!, scope);
+        if (node.type === 'identifier') {
+            const slot = scope.lookup(node.text) ?? this.fail(node, 'Not a constant');
+            return { get: () => slot.value, set: (value) => slot.value = value };
+        }
+        if (node.type === 'subscript_expression') {
+            const array = this.lvalue(node.named.argument!, scope).get();
+            if (array.type.kind !== 'array') this.fail(node, 'Subscript of a non-array');
+            const index = Number(this.toInteger(this.evaluate(node.named.index!, scope), node));
+            const elements = (array as ArrayValue).elements;
+            if (index < 0 || index >= elements.length) this.fail(node, `Index ${index} out of bounds`);
+            return { get: () => elements[index], set: (value) => elements[index] = value };
+        }
+        return this.fail(node, 'Not an assignable expression');
+    }
+
+    private assign(node: SourceNode<any>, scope: Scope): Value {
+        const target = this.lvalue(node.named.left!, scope);
+        const type = this.scalar(target.get()).type;
+        const op = node.children[1].text;
+        let value = this.scalar(this.evaluate(node.named.right!, scope));
+        if (op !== '=') value = this.arithmetic(op.slice(0, -1), this.scalar(target.get()), value, node);
+        const converted = this.convert(value, type);
+        target.set(converted);
+        return converted;
+    }
+
+    private unary(op: string, value: Scalar, node: SourceNode<any>): Scalar {
+        if (op === '!') return { type: INT, value: this.truthy(value) ? 0n : 1n };
+        const promoted = this.convert(value, this.promote(value.type));
+        if (op === '+') return promoted;
+        if (op === '-') {
+            return promoted.type.kind === 'float' ? { ...promoted, value: -(promoted.value as number) }
+                : this.arithmetic('-', { type: promoted.type, value: 0n }, promoted, node);
+        }
+        if (op === '~' && promoted.type.kind === 'int') return this.wrap(promoted.type, ~(promoted.value as bigint), node, false);
+        return this.fail(node, `Unsupported operator '${op}'`);
+    }
+
+    private binary(node: SourceNode<any>, scope: Scope): Scalar {
+        const op = node.children[1].text;
+        const left = this.scalar(this.evaluate(node.named.left!, scope));
+        if (op === '&&' || op === '||') {
+            const decided = op === '&&' ? !this.truthy(left) : this.truthy(left);
+            if (decided) return { type: INT, value: op === '||' ? 1n : 0n };
+            return { type: INT, value: this.truthy(this.evaluate(node.named.right!, scope)) ? 1n : 0n };
+        }
+        return this.arithmetic(op, left, this.scalar(this.evaluate(node.named.right!, scope)), node);
+    }
+
+    private arithmetic(op: string, a: Scalar, b: Scalar, node: SourceNode<any>): Scalar {
+        if (op === '<<' || op === '>>') {
+            const type = this.promote(a.type);
+            const x = this.toInteger(this.convert(a, type), node);
+            const n = this.toInteger(b, node);
+            if (n < 0n || n >= BigInt(type.bits)) this.fail(node, 'Shift count out of range');
+            if (op === '>>') return { type, value: x >> n };
+            if (type.signed && x < 0n) this.fail(node, 'Left shift of a negative value');
+            return this.wrap(type, x << n, node, type.signed);
+        }
+        const type = this.commonType(a.type, b.type);
+        const x = this.convert(a, type).value;
+        const y = this.convert(b, type).value;
+        const compare = (result: boolean): Scalar => ({ type: INT, value: result ? 1n : 0n });
+        switch (op) {
+            case '==': return compare(x === y);
+            case '!=': return compare(x !== y);
+            case '<': return compare(x < y);
+            case '>': return compare(x > y);
+            case '<=': return compare(x <= y);
+            case '>=': return compare(x >= y);
+        }
+        if (type.kind === 'float') {
+            const fx = x as number, fy = y as number;
+            const result = op === '+' ? fx + fy : op === '-' ? fx - fy : op === '*' ? fx * fy : op === '/' ? fx / fy : this.fail(node, `Unsupported operator '${op}' on floating point`);
+            return { type, value: type.bits === 32 ? Math.fround(result) : result };
+        }
+        const ix = x as bigint, iy = y as bigint;
+        if ((op === '/' || op === '%') && iy === 0n) this.fail(node, 'Division by zero');
+        switch (op) {
+            case '+': return this.wrap(type, ix + iy, node, type.signed);
+            case '-': return this.wrap(type, ix - iy, node, type.signed);
+            case '*': return this.wrap(type, ix * iy, node, type.signed);
+            case '/': return this.wrap(type, ix / iy, node, type.signed); // BigInt division truncates like C
+            case '%': return this.wrap(type, ix % iy, node, type.signed);
+            case '&': return this.wrap(type, ix & iy, node, false);
+            case '|': return this.wrap(type, ix | iy, node, false);
+            case '^': return this.wrap(type, ix ^ iy, node, false);
+        }
+        return this.fail(node, `Unsupported operator '${op}'`);
+    }
+
+    /** Reduces an exact result to `type`: unsigned arithmetic wraps, signed overflow is refused. */
+    private wrap(type: ScalarType, value: bigint, node: SourceNode<any>, checkOverflow: boolean): Scalar {
+        const wrapped = type.signed ? BigInt.asIntN(type.bits, value) : BigInt.asUintN(type.bits, value);
+        if (checkOverflow && wrapped !== value) this.fail(node, `Signed overflow in ${type.name}`);
+        return { type, value: wrapped };
+    }
+
+    private promote(type: ScalarType): ScalarType {
+        return type.kind === 'int' && type.bits < 32 ? INT : type;
+    }
+
+    private commonType(a: ScalarType, b: ScalarType): ScalarType {
+        if (a.kind === 'float' || b.kind === 'float') {
+            const bits = Math.max(a.kind === 'float' ? a.bits : 0, b.kind === 'float' ? b.bits : 0);
+            return bits === 32 ? FLOAT : DOUBLE;
+        }
+        a = this.promote(a);
+        b = this.promote(b);
+        if (a.signed === b.signed) return a.bits >= b.bits ? a : b;
+        const [unsigned, signed] = a.signed ? [b, a] : [a, b];
+        return unsigned.bits >= signed.bits ? unsigned : signed;
+    }
+
+    private convert(value: Scalar, type: ScalarType): Scalar {
+        if (type === BOOL) return { type, value: this.truthy(value) ? 1n : 0n };
+        if (type.kind === 'float') {
+            const number = typeof value.value === 'bigint' ? Number(value.value) : value.value;
+            return { type, value: type.bits === 32 ? Math.fround(number) : number };
+        }
+        let integer: bigint;
+        if (typeof value.value === 'number') {
+            if (!Number.isFinite(value.value)) this.fail(null, 'Non-finite value converted to an integer');
+            integer = BigInt(Math.trunc(value.value));
+            const min = type.signed ? -(1n << BigInt(type.bits - 1)) : 0n;
+            const max = type.signed ? (1n << BigInt(type.bits - 1)) - 1n : (1n << BigInt(type.bits)) - 1n;
+            if (integer < min || integer > max) this.fail(null, `Floating value out of range for ${type.name}`);
+        } else {
+            integer = value.value;
+        }
+        return { type, value: type.signed ? BigInt.asIntN(type.bits, integer) : BigInt.asUintN(type.bits, integer) };
+    }
+
+    private truthy(value: Value): boolean {
+        const scalar = this.scalar(value);
+        return scalar.value !== 0n && scalar.value !== 0;
+    }
+
+    private toInteger(value: Value, node: SourceNode<any>): bigint {
+        const scalar = this.scalar(value);
+        if (scalar.type.kind !== 'int') this.fail(node, 'Integer expected');
+        return scalar.value as bigint;
+    }
+
+    private scalar(value: Value): Scalar {
+        if (value.type.kind === 'array') this.fail(null, 'Arrays can only be indexed');
+        return value as Scalar;
+    }
+}
+
+class Scope {
+    private readonly slots = new Map<string, { value: Value }>();
+    private readonly parent: Scope | null;
+
+    constructor(parent: Scope | null) {
+        this.parent = parent;
+    }
+
+    declare(name: string, value: Value): void {
+        this.slots.set(name, { value });
+    }
+
+    lookup(name: string): { value: Value } | null {
+        return this.slots.get(name) ?? this.parent?.lookup(name) ?? null;
+    }
+}
+
+function sizeOf(type: CType): number {
+    if (type.kind === 'array') return type.length * sizeOf(type.element);
+    return type === BOOL ? 1 : type.bits / 8;
+}
+
+/**
+ * Parses a C integer or floating literal into its value and C type.
+ * @param {string} text - Literal text, e.g. `0x1fu`, `10l`, `2.5f`.
+ * @returns {Scalar | null} The value, or null for forms that are not supported.
+ */
+function parseNumber(text: string): Scalar | null {
+    const lower = text.toLowerCase();
+    const isHex = lower.startsWith('0x');
+    if (!isHex && /[.e]/.test(lower) || isHex && lower.includes('p')) {
+        if (lower.endsWith('l')) return null; // long double
+        const isFloat = lower.endsWith('f');
+        const value = Number(isHex ? NaN : lower.replace(/f$/, ''));
+        if (Number.isNaN(value)) return null;
+        return { type: isFloat ? FLOAT : DOUBLE, value: isFloat ? Math.fround(value) : value };
+    }
+    const suffix = lower.match(/[ul]*$/)![0];
+    const digits = lower.slice(0, lower.length - suffix.length);
+    let value: bigint;
+    try {
+        value = lower.startsWith('0b') ? BigInt(digits) : isHex ? BigInt(digits) : /^0[0-7]+$/.test(digits) ? BigInt('0o' + digits.slice(1)) : BigInt(digits);
+    } catch {
+        return null;
+    }
+    // The first type in C's list for this kind of literal that can hold the value
+    const unsigned = suffix.includes('u');
+    const long = suffix.includes('l');
+    const decimal = !isHex && !lower.startsWith('0b') && !/^0[0-7]+$/.test(digits);
+    const candidates = [
+        ...(long ? [] : unsigned ? [UINT] : decimal ? [INT] : [INT, UINT]),
+        ...(unsigned ? [ULONG] : decimal ? [LONG] : [LONG, ULONG])
+    ];
+    const type = candidates.find(t => value <= (t.signed ? (1n << BigInt(t.bits - 1)) - 1n : (1n << BigInt(t.bits)) - 1n));
+    return type ? { type, value } : null;
+}
+
+const ESCAPES: Record<string, number> = { n: 10, t: 9, r: 13, '0': 0, '\\': 92, "'": 39, '"': 34, a: 7, b: 8, f: 12, v: 11, '?': 63 };
+
+function parseChar(text: string): number | null {
+    const body = text.slice(1, -1);
+    if (body.length === 1) return body.charCodeAt(0);
+    if (!body.startsWith('\\')) return null;
+    if (/^\\x[0-9a-f]+$/i.test(body)) return parseInt(body.slice(2), 16);
+    if (/^\\[0-7]{1,3}$/.test(body)) return parseInt(body.slice(1), 8);
+    return ESCAPES[body.slice(1)] ?? null;
+}
+
+/**
+ * Prints a value as a C literal that has the same type, so folding a call does
+ * not change the type of the surrounding expression.
+ * @param {Scalar} value - The value to print.
+ * @returns {string} The literal, parenthesised when negative.
+ */
+export function formatLiteral(value: Scalar): string {
+    const { type } = value;
+    if (type.kind === 'float') {
+        const number = value.value as number;
+        if (!Number.isFinite(number)) throw new ConstEvalError('Result is not finite');
+        // The shortest text that reads back as the same value
+        let text = String(Math.abs(number));
+        if (type.bits === 32) {
+            for (let digits = 1; digits <= 9; digits++) {
+                text = Math.abs(number).toPrecision(digits);
+                if (Math.fround(Number(text)) === Math.abs(number)) break;
+            }
+        }
+        if (!/[.e]/.test(text)) text += '.0';
+        text += type.bits === 32 ? 'f' : '';
+        return number < 0 || Object.is(number, -0) ? `(-${text})` : text;
+    }
+    const integer = value.value as bigint;
+    if (type === BOOL) return integer ? '1' : '0';
+    if (type.bits < 32) return `((${type.name})${integer})`;
+    const suffix = (type.signed ? '' : 'u') + (type.bits === 64 ? (type.name.includes('long long') ? 'll' : 'l') : '');
+    if (integer >= 0n) return `${integer}${suffix}`;
+    // The most negative value has no literal of its own
+    const min = -(1n << BigInt(type.bits - 1));
+    return integer === min ? `(${integer + 1n}${suffix} - 1)` : `(${integer}${suffix})`;
+}
@@ -1,4 +1,5 @@
 import path from 'path';
+import type { DiagnosticsFormat } from './diagnostics.ts';
 
 export interface SourceInfo {
     cFile: string;
@@ -19,15 +20,74 @@ export interface CompilerCommand {
     file?: string;
     files?: string[];
     additionalIncludes?: string[];
+    /** Output path for a Chrome trace-event profile (`--profile=<file>`). */
+    profile?: string;
+    /** Number of rows in the profile summary (`--profile-top=<n>`). */
+    profileTop?: number;
+    /** Print transformation counters (`--stats`), or write them as JSON (`--stats=<file>`). */
+    stats?: true | string;
+    /** Print a memory report (`--mem-report`), or write it as JSON (`--mem-report=<file>`). */
+    memReport?: true | string;
+    /** Heap size in MB above which a heap snapshot is written (`--mem-snapshot-at=<MB>`). */
+    memSnapshotAt?: number;
+    /** Release native tree-sitter trees once wrapped (`--compact`). */
+    compact?: boolean;
+    /** Collect diagnostics as 'json' or 'sarif' instead of printing them (`--diagnostics-format=`). */
+    diagnosticsFormat?: DiagnosticsFormat;
+    /** File the collected diagnostics are written to (`--diagnostics-output=<file>`). */
+    diagnosticsOutput?: string;
+}
+
+/**
+ * Removes upp's own instrumentation options from the argument list so they are
+ * never forwarded to the underlying compiler.
+ * @param {string[]} args - Raw arguments.
+ * @returns {{ args: string[], options: Partial<CompilerCommand> }} Remaining arguments and parsed options.
+ */
+function extractUppOptions(args: string[]): { args: string[]; options: Partial<CompilerCommand> } {
+    const options: Partial<CompilerCommand> = {};
+    const rest: string[] = [];
+    for (const arg of args) {
+        if (arg.startsWith('--profile=')) {
+            options.profile = path.resolve(arg.slice('--profile='.length));
+        } else if (arg === '--stats') {
+            options.stats = true;
+        } else if (arg.startsWith('--stats=')) {
+            options.stats = path.resolve(arg.slice('--stats='.length));
+        } else if (arg.startsWith('--diagnostics-format=')) {
+            const format = arg.slice('--diagnostics-format='.length);
+            if (format !== 'text' && format !== 'json' && format !== 'sarif') {
+                console.error(`Error: unknown diagnostics format '${format}'. Expected --diagnostics-format=text, json or sarif.`);
+                process.exit(1);
+            }
+            options.diagnosticsFormat = format;
+        } else if (arg.startsWith('--diagnostics-output=')) {
+            options.diagnosticsOutput = path.resolve(arg.slice('--diagnostics-output='.length));
+        } else if (arg === '--compact') {
+            options.compact = true;
+        } else if (arg === '--mem-report') {
+            options.memReport = true;
+        } else if (arg.startsWith('--mem-report=')) {
+            options.memReport = path.resolve(arg.slice('--mem-report='.length));
+        } else if (arg.startsWith('--mem-snapshot-at=')) {
+            options.memSnapshotAt = parseFloat(arg.slice('--mem-snapshot-at='.length)) || undefined;
+        } else if (arg.startsWith('--profile-top=')) {
+            options.profileTop = parseInt(arg.slice('--profile-top='.length), 10) || undefined;
+        } else {
+            rest.push(arg);
+        }
+    }
+    return { args: rest, options };
 }
 
 /**
  * Parses command line arguments for the upp compiler wrapper.
  * Expects args to be [compiler, ...compiler_args]
- * @param {string[]} args - Raw arguments from process.argv.slice(2).
+ * @param {string[]} rawArgs - Raw arguments from process.argv.slice(2).
  * @returns {CompilerCommand} The parsed command info.
  */
-export function parseArgs(args: string[]): CompilerCommand {
+export function parseArgs(rawArgs: string[]): CompilerCommand {
+    const { args, options } = extractUppOptions(rawArgs);
     if (args.length === 0) {
         return { isUppCommand: false };
     }
@@ -67,7 +127,8 @@ export function parseArgs(args: string[]): CompilerCommand {
             compiler: 'cc',
             sources: [],
             includePaths: includePaths,
-            depFlags: []
+            depFlags: [],
+            ...options
         };
     }
 
@@ -129,6 +190,7 @@ export function parseArgs(args: string[]): CompilerCommand {
         sources,
         includePaths,
         depFlags,
-        depOutputFile
+        depOutputFile,
+        ...options
     };
 }
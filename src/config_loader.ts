@@ -42,14 +42,104 @@ export interface UppConfig {
     diagnostics?: DiagnosticsManager;
     suppress?: string[];
     extends?: string;
+    /** Release native tree-sitter trees after wrapping (see `SourceTree.compact`). */
+    compact?: boolean;
+}
+
+/** Identifies a version of a file on disk; a missing file has mtimeMs and size of -1. */
+interface FileStamp {
+    path: string;
+    mtimeMs: number;
+    size: number;
+}
+
+/** What resolveConfig needs to know about a directory, valid while its stamp is unchanged. */
+interface DirectoryEntry {
+    stamp: FileStamp;
+    hasConfig: boolean;
+    hasGit: boolean;
+    readable: boolean;
 }
 
 /**
- * Loads a config file and recursively handles "extends".
+ * Parsed config files, keyed by path. Each entry records the stamps of every file
+ * in its "extends" chain, so editing any of them invalidates it.
+ */
+const configFileCache = new Map<string, { config: UppConfig; stamps: FileStamp[] }>();
+
+/**
+ * Directory lookups made while searching for upp.json. Adding or removing upp.json
+ * or .git changes the directory's mtime, which invalidates the entry.
+ */
+const directoryCache = new Map<string, DirectoryEntry>();
+
+/**
+ * Resolved configs, keyed by source directory. Each entry records the stamps of the
+ * directories searched and of the config chain it loaded.
+ */
+const resolvedCache = new Map<string, { config: Readonly<UppConfig>; stamps: FileStamp[] }>();
+
+/**
+ * Stats a file for cache validation.
+ * @param {string} filePath - The file to stat.
+ * @returns {FileStamp}
+ */
+function stampOf(filePath: string): FileStamp {
+    try {
+        const stat = fs.statSync(filePath);
+        return { path: filePath, mtimeMs: stat.mtimeMs, size: stat.size };
+    } catch {
+        return { path: filePath, mtimeMs: -1, size: -1 };
+    }
+}
+
+/**
+ * Checks that none of the stamped files changed since they were recorded.
+ * @param {FileStamp[]} stamps - Stamps taken when the entry was cached.
+ * @returns {boolean}
+ */
+function isFresh(stamps: FileStamp[]): boolean {
+    return stamps.every(s => {
+        const now = stampOf(s.path);
+        return now.mtimeMs === s.mtimeMs && now.size === s.size;
+    });
+}
+
+/**
+ * Returns the cached view of a directory, refreshing it if the directory changed.
+ * @param {string} dir - Absolute directory path.
+ * @returns {DirectoryEntry}
+ */
+function directoryInfo(dir: string): DirectoryEntry {
+    const stamp = stampOf(dir);
+    const cached = directoryCache.get(dir);
+    if (cached && cached.stamp.mtimeMs === stamp.mtimeMs && cached.stamp.size === stamp.size) return cached;
+
+    let readable = true;
+    try {
+        fs.accessSync(dir, fs.constants.R_OK);
+    } catch (err) {
+        readable = false;
+    }
+    const entry: DirectoryEntry = {
+        stamp,
+        hasConfig: fs.existsSync(path.join(dir, 'upp.json')),
+        hasGit: fs.existsSync(path.join(dir, '.git')),
+        readable
+    };
+    directoryCache.set(dir, entry);
+    return entry;
+}
+
+/**
+ * Reads a config file and recursively handles "extends", recording a stamp for each file read.
  * @param {string} configPath - Path to the JSON config file.
+ * @param {FileStamp[]} stamps - Receives the stamps of the files in the chain.
  * @returns {UppConfig} The loaded and merged configuration object.
  */
-function loadConfig(configPath: string): UppConfig {
+function readConfigChain(configPath: string, stamps: FileStamp[]): UppConfig {
+    // Stamp before reading, so a write racing with the read invalidates the entry
+    stamps.push(stampOf(configPath));
     if (!fs.existsSync(configPath)) return {};
 
     const configDir = path.dirname(configPath);
@@ -82,7 +172,7 @@ function loadConfig(configPath: string): UppConfig {
             parentPath = path.join(parentPath, 'upp.json');
         }
 
-        const parentConfig = loadConfig(parentPath);
+        const parentConfig = readConfigChain(parentPath, stamps);
         config = deepMerge(parentConfig, config);
         delete config.extends;
     }
@@ -90,51 +180,112 @@ function loadConfig(configPath: string): UppConfig {
     return config as UppConfig;
 }
 
+/**
+ * Freezes a parsed config and everything it holds, so cached configs can be shared.
+ * @param {T} value - A value parsed from JSON.
+ * @returns {Readonly<T>} The same value, frozen.
+ */
+function deepFreeze<T>(value: T): Readonly<T> {
+    if (value !== null && typeof value === 'object' && !Object.isFrozen(value)) {
+        Object.freeze(value);
+        for (const child of Object.values(value)) deepFreeze(child);
+    }
+    return value;
+}
+
+/**
+ * Returns the cache entry for a config file, re-reading its chain if any file in it changed.
+ * @param {string} configPath - Path to the JSON config file.
+ * @returns {{ config: Readonly<UppConfig>, stamps: FileStamp[] }}
+ */
+function configFileEntry(configPath: string): { config: Readonly<UppConfig>; stamps: FileStamp[] } {
+    const cached = configFileCache.get(configPath);
+    if (cached && isFresh(cached.stamps)) return cached;
+
+    const stamps: FileStamp[] = [];
+    const entry = { config: deepFreeze(readConfigChain(configPath, stamps)), stamps };
+    configFileCache.set(configPath, entry);
+    return entry;
+}
+
+/**
+ * Loads a config file and recursively handles "extends".
+ * Parsed chains are cached and revalidated by the mtime and size of every file in the chain.
+ * @param {string} configPath - Path to the JSON config file.
+ * @returns {Readonly<UppConfig>} The loaded and merged configuration, frozen and shared between callers.
+ */
+function loadConfig(configPath: string): Readonly<UppConfig> {
+    return configFileEntry(configPath).config;
+}
+
 /**
  * Resolves the configuration for a given source file path.
  * Searches up the directory tree for upp.json until .git or root is reached.
+ * Results are cached per source directory and revalidated by the stamps of the
+ * directories searched and the config files loaded.
  * @param {string} sourcePath - Absolute path to the source file.
- * @returns {UppConfig} The resolved configuration.
+ * @returns {Readonly<UppConfig>} The resolved configuration, frozen and shared between callers.
  */
-function resolveConfig(sourcePath: string): UppConfig {
-    let currentDir = path.dirname(path.resolve(sourcePath));
+function resolveConfig(sourcePath: string): Readonly<UppConfig> {
+    const sourceDir = path.dirname(path.resolve(sourcePath));
+    const cached = resolvedCache.get(sourceDir);
+    if (cached && isFresh(cached.stamps)) return cached.config;
+
+    const stamps: FileStamp[] = [];
+    let currentDir = sourceDir;
     let configPath: string | null = null;
 
     while (true) {
-        const potentialPath = path.join(currentDir, 'upp.json');
-        if (fs.existsSync(potentialPath)) {
-            configPath = potentialPath;
+        const dir = directoryInfo(currentDir);
+        stamps.push(dir.stamp);
+        if (dir.hasConfig) {
+            configPath = path.join(currentDir, 'upp.json');
             break;
         }
 
         // Stop if .git is found
-        if (fs.existsSync(path.join(currentDir, '.git'))) {
+        if (dir.hasGit) {
             break;
         }
 
         const parentDir = path.dirname(currentDir);
         if (parentDir === currentDir) break; // Reached root
 
-        try {
-            fs.accessSync(parentDir, fs.constants.R_OK);
-        } catch (err) {
+        const parent = directoryInfo(parentDir);
+        if (!parent.readable) {
+            stamps.push(parent.stamp);
             break; // No permission
         }
 
         currentDir = parentDir;
     }
 
-    if (configPath) {
-        return loadConfig(configPath);
+    // Final fallback: check UPP installation directory
+    if (!configPath) {
+        const installDir = directoryInfo(UPP_INSTALL_DIR);
+        stamps.push(installDir.stamp);
+        if (installDir.hasConfig) configPath = path.join(UPP_INSTALL_DIR, 'upp.json');
     }
 
-    // Final fallback: check UPP installation directory
-    const installConfigPath = path.join(UPP_INSTALL_DIR, 'upp.json');
-    if (fs.existsSync(installConfigPath)) {
-        return loadConfig(installConfigPath);
+    let config: Readonly<UppConfig>;
+    if (configPath) {
+        const entry = configFileEntry(configPath);
+        stamps.push(...entry.stamps);
+        config = entry.config;
+    } else {
+        config = deepFreeze({ lang: {} }); // Empty default if none found
     }
+    resolvedCache.set(sourceDir, { config, stamps });
+    return config;
+}
 
-    return { lang: {} }; // Return empty default if none found
+/**
+ * Drops all cached directory lookups, parsed config files and resolved configs.
+ */
+function clearConfigCache(): void {
+    configFileCache.clear();
+    directoryCache.clear();
+    resolvedCache.clear();
 }
 
-export { resolveConfig, loadConfig, deepMerge };
+export { resolveConfig, loadConfig, deepMerge, clearConfigCache };
@@ -1,3 +1,6 @@
+import fs from 'fs';
+import path from 'path';
+
 /**
  * Enum for Diagnostic Codes.
  * @readonly
@@ -9,8 +12,94 @@ export const DiagnosticCodes = {
     SYNTAX_ERROR: 'UPP003'
 } as const;
 
+export type DiagnosticsFormat = 'text' | 'json' | 'sarif';
+
 export interface DiagnosticsConfig {
     suppress?: string[];
+    /** 'text' prints each report to stderr; 'json' and 'sarif' collect reports and write them on flush(). */
+    format?: DiagnosticsFormat;
+    /** File written by flush() in json/sarif mode. Defaults to stderr. */
+    output?: string;
+}
+
+/** A collected diagnostic, as written in json mode. */
+export interface Diagnostic {
+    severity: 'warning' | 'error';
+    code: string | number;
+    message: string;
+    file: string;
+    /** 1-indexed; 0 when unknown. */
+    line: number;
+    /** 1-indexed; 0 when unknown. */
+    col: number;
+}
+
+/**
+ * Table of line start offsets for a source string, built once, giving
+ * O(log n) offset to line/column lookups.
+ * @class
+ */
+export class LineIndex {
+    public source: string;
+    private starts: number[];
+    private static cache = new Map<string, LineIndex>();
+    private static readonly CACHE_LIMIT = 32;
+
+    /**
+     * @param {string} source - Source code.
+     */
+    constructor(source: string) {
+        this.source = source;
+        this.starts = [0];
+        for (let i = source.indexOf('\n'); i !== -1; i = source.indexOf('\n', i + 1)) {
+            this.starts.push(i + 1);
+        }
+    }
+
+    /**
+     * Returns the index for a source, keeping one per distinct source so that
+     * interleaved lookups across files do not rebuild each other's tables.
+     * The oldest entry is dropped once CACHE_LIMIT sources are held.
+     * @param {string} source - Source code.
+     * @returns {LineIndex}
+     */
+    static of(source: string): LineIndex {
+        let index = LineIndex.cache.get(source);
+        if (!index) {
+            if (LineIndex.cache.size >= LineIndex.CACHE_LIMIT) {
+                LineIndex.cache.delete(LineIndex.cache.keys().next().value!);
+            }
+            index = new LineIndex(source);
+            LineIndex.cache.set(source, index);
+        }
+        return index;
+    }
+
+    /**
+     * @param {number} index - Character index.
+     * @returns {{line: number, col: number}} 1-indexed line and col.
+     */
+    lineCol(index: number): { line: number; col: number } {
+        const offset = Math.max(0, Math.min(index, this.source.length));
+        let lo = 0;
+        let hi = this.starts.length - 1;
+        while (lo < hi) {
+            const mid = (lo + hi + 1) >> 1;
+            if (this.starts[mid] <= offset) lo = mid;
+            else hi = mid - 1;
+        }
+        return { line: lo + 1, col: offset - this.starts[lo] + 1 };
+    }
+
+    /**
+     * @param {number} line - 1-indexed line number.
+     * @returns {string | undefined} The line's text without its newline.
+     */
+    lineText(line: number): string | undefined {
+        if (line < 1 || line > this.starts.length) return undefined;
+        const end = line < this.starts.length ? this.starts[line] - 1 : this.source.length;
+        return this.source.slice(this.starts[line - 1], end);
+    }
 }
 
 /**
@@ -19,13 +108,19 @@ export interface DiagnosticsConfig {
  */
 export class DiagnosticsManager {
     private suppressed: Set<string | number>;
+    public format: DiagnosticsFormat;
+    public output: string | null;
+    public collected: Diagnostic[] = [];
+    private flushedCount: number = -1;
 
     /**
-     * @param {DiagnosticsConfig} [config={}] - Configuration object with suppression list.
+     * @param {DiagnosticsConfig} [config={}] - Configuration object with suppression list and output mode.
      */
     constructor(config: DiagnosticsConfig = {}) {
         /** @type {Set<string | number>} */
         this.suppressed = new Set(config.suppress || []);
+        this.format = config.format || 'text';
+        this.output = config.output || null;
     }
 
     /**
@@ -40,14 +135,16 @@ export class DiagnosticsManager {
     reportWarning(code: string | number, message: string, filePath: string, line: number = 0, col: number = 0, sourceCode: string | null = null): void {
         if (this.suppressed.has(code)) return;
 
+        if (this.format !== 'text') {
+            this.collected.push({ severity: 'warning', code, message, file: filePath, line, col });
+            return;
+        }
+
         const loc = line > 0 ? `:${line}:${col}` : '';
         console.warn(`\x1b[33m${filePath}${loc}: warning: [${code}] ${message}\x1b[0m`);
 
         if (sourceCode && line > 0) {
-            // Re-split source to find line content.
-            // This is efficient enough for warnings which shouldn't be spammy.
-            const lines = sourceCode.split('\n');
-            const lineContent = lines[line - 1];
+            const lineContent = LineIndex.of(sourceCode).lineText(line);
             if (lineContent !== undefined) {
                 console.warn(lineContent);
                 console.warn(' '.repeat(Math.max(0, col - 1)) + '\x1b[33m^\x1b[0m');
@@ -66,19 +163,75 @@ export class DiagnosticsManager {
      * @param {boolean} [fatal=true] - Whether to exit the process.
      */
     reportError(code: string | number, message: string, filePath: string, line: number = 0, col: number = 0, sourceCode: string | null = null, fatal: boolean = true): void {
-        const loc = line > 0 ? `:${line}:${col}` : '';
-        console.error(`\x1b[31m${filePath}${loc}: error: [${code}] ${message}\x1b[0m`);
+        if (this.format !== 'text') {
+            this.collected.push({ severity: 'error', code, message, file: filePath, line, col });
+        } else {
+            const loc = line > 0 ? `:${line}:${col}` : '';
+            console.error(`\x1b[31m${filePath}${loc}: error: [${code}] ${message}\x1b[0m`);
 
-        if (sourceCode && line > 0) {
-            const lines = sourceCode.split('\n');
-            const lineContent = lines[line - 1];
-            if (lineContent !== undefined) {
-                console.error(lineContent);
-                console.error(' '.repeat(Math.max(0, col - 1)) + '\x1b[31m^\x1b[0m');
+            if (sourceCode && line > 0) {
+                const lineContent = LineIndex.of(sourceCode).lineText(line);
+                if (lineContent !== undefined) {
+                    console.error(lineContent);
+                    console.error(' '.repeat(Math.max(0, col - 1)) + '\x1b[31m^\x1b[0m');
+                }
             }
         }
 
-        if (fatal) process.exit(1);
+        if (fatal) {
+            this.flush();
+            process.exit(1);
+        }
+    }
+
+    /**
+     * Writes all collected diagnostics in json or sarif format. Safe to call more
+     * than once (e.g. before a fatal exit and again from an exit handler); nothing
+     * is rewritten unless new diagnostics arrived. Does nothing in text mode,
+     * where reports are printed immediately.
+     */
+    flush(): void {
+        if (this.format === 'text' || this.collected.length === this.flushedCount) return;
+        if (!this.output && this.collected.length === 0) return;
+        const document = this.format === 'sarif' ? this.toSarif() : this.collected;
+        const text = JSON.stringify(document, null, 2) + '\n';
+        if (this.output) fs.writeFileSync(this.output, text);
+        else process.stderr.write(text);
+        this.flushedCount = this.collected.length;
+    }
+
+    /**
+     * Converts the collected diagnostics to a SARIF 2.1.0 log.
+     * @returns {Object}
+     */
+    toSarif(): Record<string, unknown> {
+        const names = Object.fromEntries(Object.entries(DiagnosticCodes).map(([name, id]) => [id, name]));
+        const ruleIds = [...new Set(this.collected.map(d => String(d.code)))];
+        const uri = (file: string) => (path.isAbsolute(file) ? path.relative(process.cwd(), file) : file).split(path.sep).join('/');
+        return {
+            $schema: 'https://json.schemastore.org/sarif-2.1.0.json',
+            version: '2.1.0',
+            runs: [{
+                tool: {
+                    driver: {
+                        name: 'upp',
+                        informationUri: 'https://github.com/MatAtBread/upp',
+                        rules: ruleIds.map(id => names[id] ? { id, name: names[id] } : { id })
+                    }
+                },
+                results: this.collected.map(d => ({
+                    ruleId: String(d.code),
+                    level: d.severity,
+                    message: { text: d.message },
+                    locations: [{
+                        physicalLocation: {
+                            artifactLocation: { uri: uri(d.file) },
+                            ...(d.line > 0 ? { region: { startLine: d.line, startColumn: Math.max(1, d.col) } } : {})
+                        }
+                    }]
+                }))
+            }]
+        };
     }
 
     /**
@@ -88,16 +241,6 @@ export class DiagnosticsManager {
      * @returns {{line: number, col: number}} 1-indexed line and col.
      */
     static getLineCol(source: string, index: number): { line: number; col: number } {
-        let line = 1;
-        let col = 1;
-        for (let i = 0; i < index && i < source.length; i++) {
-            if (source[i] === '\n') {
-                line++;
-                col = 1;
-            } else {
-                col++;
-            }
-        }
-        return { line, col };
+        return LineIndex.of(source).lineCol(index);
     }
 }
@@ -0,0 +1,75 @@
+import fs from 'fs';
+import path from 'path';
+
+/**
+ * Caches filesystem lookups made while resolving @include and core files.
+ *
+ * Directory listings are read once per search directory, so probing a name
+ * against many include paths costs a Set lookup per path instead of a stat, and
+ * resolved names (including misses) are remembered per search-path list.
+ *
+ * Entries are never revalidated, so a cache must not outlive one build: the CLI
+ * creates one per invocation, and a Registry without one creates its own that
+ * its dependency registries share. A long-lived host that passes its own cache
+ * should create a new one, or call `clear()`, for each build.
+ */
+export class FileLookupCache {
+    /** Directory -> entry names, or null if the directory could not be read. */
+    private listings: Map<string, Set<string> | null> = new Map();
+    /** (search paths, name) -> resolved path, or null for a miss. */
+    private resolved: Map<string, string | null> = new Map();
+
+    /**
+     * Checks whether a file or directory exists, using the cached listing of its parent.
+     * @param {string} filePath - Path to check.
+     * @returns {boolean}
+     */
+    exists(filePath: string): boolean {
+        const abs = path.resolve(filePath);
+        const dir = path.dirname(abs);
+        if (dir === abs) return fs.existsSync(abs); // filesystem root
+        return this.listing(dir)?.has(path.basename(abs)) ?? false;
+    }
+
+    /**
+     * Finds the first search directory containing `name`.
+     * @param {string} name - The file name, possibly with subdirectories, or an absolute path.
+     * @param {string[]} searchPaths - Directories to try, in order.
+     * @returns {string | null} The resolved absolute path, or null if not found.
+     */
+    resolve(name: string, searchPaths: string[]): string | null {
+        const key = `${searchPaths.join('\0')}\0\0${name}`;
+        const cached = this.resolved.get(key);
+        if (cached !== undefined) return cached;
+
+        let found: string | null = null;
+        for (const dir of searchPaths) {
+            const candidate = path.resolve(dir, name);
+            if (this.exists(candidate)) {
+                found = candidate;
+                break;
+            }
+        }
+        this.resolved.set(key, found);
+        return found;
+    }
+
+    /** Forgets all listings and resolved names. */
+    clear(): void {
+        this.listings.clear();
+        this.resolved.clear();
+    }
+
+    private listing(dir: string): Set<string> | null {
+        let entries = this.listings.get(dir);
+        if (entries === undefined) {
+            try {
+                entries = new Set(fs.readdirSync(dir));
+            } catch {
+                entries = null;
+            }
+            this.listings.set(dir, entries);
+        }
+        return entries;
+    }
+}
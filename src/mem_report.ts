@@ -0,0 +1,201 @@
+import v8 from 'v8';
+import vm from 'vm';
+import path from 'path';
+import { performance } from 'perf_hooks';
+
+/** Kinds of object whose lifetimes are tracked. */
+type TrackedKind = 'node' | 'tree' | 'native';
+
+interface TrackedToken {
+    kind: TrackedKind;
+    /** For trees: why the tree was created ('source', 'fragment', 'remove', 'clone', 'transform', ...). */
+    origin?: string;
+}
+
+/** Heap usage and live object counts at the end of a phase. */
+export interface MemorySample {
+    phase: string;
+    /** Milliseconds since the report was created. */
+    at: number;
+    heapUsed: number;
+    heapTotal: number;
+    external: number;
+    rss: number;
+    liveNodes: number;
+    liveTrees: number;
+    liveNativeTrees: number;
+}
+
+export interface MemoryReportOptions {
+    /** Write a heap snapshot the first time heapUsed exceeds this many bytes. */
+    snapshotThreshold?: number;
+    /** Directory heap snapshots are written to. Defaults to the working directory. */
+    snapshotDir?: string;
+}
+
+/**
+ * Tracks memory use of a transformation: heap usage sampled per phase, and the
+ * number of live SourceNode/SourceTree wrappers and native tree-sitter trees.
+ *
+ * Lifetimes are tracked with a FinalizationRegistry, whose callbacks only run
+ * between tasks. upp transforms synchronously, so call `settle()` (which forces
+ * a collection and yields) before reading counts that should be exact.
+ *
+ * Instrumentation sites go through `MemoryReport.active`, so tracking costs a
+ * single null check when disabled.
+ */
+export class MemoryReport {
+    /** The report receiving samples, or null when memory reporting is disabled. */
+    static active: MemoryReport | null = null;
+
+    public samples: MemorySample[] = [];
+    public created: Record<TrackedKind, number> = { node: 0, tree: 0, native: 0 };
+    public live: Record<TrackedKind, number> = { node: 0, tree: 0, native: 0 };
+    /** Live SourceTrees per origin. */
+    public liveTrees: Map<string, number> = new Map();
+    public snapshots: string[] = [];
+    public snapshotThreshold: number;
+    private snapshotDir: string;
+    private origin: number = performance.now();
+    private finalizer: FinalizationRegistry<TrackedToken>;
+
+    /**
+     * @param {MemoryReportOptions} [options] - Reporting options.
+     */
+    constructor(options: MemoryReportOptions = {}) {
+        this.snapshotThreshold = options.snapshotThreshold ?? Infinity;
+        this.snapshotDir = options.snapshotDir ?? process.cwd();
+        this.finalizer = new FinalizationRegistry((token) => {
+            this.live[token.kind]--;
+            if (token.origin !== undefined) {
+                this.liveTrees.set(token.origin, (this.liveTrees.get(token.origin) || 0) - 1);
+            }
+        });
+    }
+
+    /**
+     * Registers a SourceTree and its native tree-sitter tree.
+     * @param {object} tree - The SourceTree.
+     * @param {object | null} nativeTree - The tree-sitter Tree it holds.
+     * @param {string} origin - Why the tree was created.
+     */
+    trackTree(tree: object, nativeTree: object | null, origin: string): void {
+        this.track(tree, { kind: 'tree', origin });
+        this.liveTrees.set(origin, (this.liveTrees.get(origin) || 0) + 1);
+        if (nativeTree) this.track(nativeTree, { kind: 'native' });
+    }
+
+    /**
+     * Registers a SourceNode wrapper.
+     * @param {object} node - The SourceNode.
+     */
+    trackNode(node: object): void {
+        this.track(node, { kind: 'node' });
+    }
+
+    private track(target: object, token: TrackedToken): void {
+        this.created[token.kind]++;
+        this.live[token.kind]++;
+        this.finalizer.register(target, token);
+    }
+
+    /**
+     * Records heap usage at the end of a phase, writing a heap snapshot the first
+     * time the configured threshold is crossed.
+     * @param {string} phase - The phase that just finished.
+     * @returns {MemorySample}
+     */
+    sample(phase: string): MemorySample {
+        const mem = process.memoryUsage();
+        const sample: MemorySample = {
+            phase,
+            at: Math.round(performance.now() - this.origin),
+            heapUsed: mem.heapUsed,
+            heapTotal: mem.heapTotal,
+            external: mem.external,
+            rss: mem.rss,
+            liveNodes: this.live.node,
+            liveTrees: this.live.tree,
+            liveNativeTrees: this.live.native
+        };
+        this.samples.push(sample);
+
+        if (mem.heapUsed > this.snapshotThreshold && this.snapshots.length === 0) {
+            const safePhase = phase.replace(/[^\w.-]+/g, '_').slice(0, 60);
+            const file = path.join(this.snapshotDir, `upp-${process.pid}-${safePhase}.heapsnapshot`);
+            this.snapshots.push(v8.writeHeapSnapshot(file));
+        }
+        return sample;
+    }
+
+    /**
+     * Forces a full collection and yields so pending finalizers run, then samples.
+     * @param {string} phase - The phase that just finished.
+     * @returns {Promise<MemorySample>}
+     */
+    async settle(phase: string): Promise<MemorySample> {
+        const gc = MemoryReport.gcFunction();
+        gc();
+        await new Promise(resolve => setImmediate(resolve));
+        gc();
+        await new Promise(resolve => setImmediate(resolve));
+        return this.sample(phase);
+    }
+
+    /** Returns `gc()`, exposing it at runtime when node was not started with --expose-gc. */
+    private static gcFunction(): () => void {
+        if (typeof globalThis.gc === 'function') return globalThis.gc as () => void;
+        v8.setFlagsFromString('--expose-gc');
+        return vm.runInNewContext('gc');
+    }
+
+    /**
+     * Detached holder trees created by `SourceNode.remove()` that are still reachable.
+     * Only meaningful after `settle()`.
+     * @returns {number}
+     */
+    get detachedTrees(): number {
+        return this.liveTrees.get('remove') || 0;
+    }
+
+    /**
+     * Serializable snapshot of the report.
+     * @returns {Object}
+     */
+    toJSON(): Record<string, unknown> {
+        return {
+            samples: this.samples,
+            created: this.created,
+            live: this.live,
+            liveTrees: Object.fromEntries(this.liveTrees),
+            detachedTrees: this.detachedTrees,
+            snapshots: this.snapshots
+        };
+    }
+
+    /**
+     * Formats the samples and live counts as a text report.
+     * @returns {string}
+     */
+    format(): string {
+        const mb = (bytes: number) => (bytes / (1024 * 1024)).toFixed(1).padStart(9);
+        const n = (v: number) => String(v).padStart(9);
+        const lines = [
+            `[upp] memory:`,
+            `  ${'ms'.padStart(7)} ${'heap MB'.padStart(9)} ${'ext MB'.padStart(9)} ${'rss MB'.padStart(9)} ${'nodes'.padStart(9)} ${'trees'.padStart(9)} ${'native'.padStart(9)}  phase`
+        ];
+        for (const s of this.samples) {
+            lines.push(`  ${String(s.at).padStart(7)} ${mb(s.heapUsed)} ${mb(s.external)} ${mb(s.rss)} ${n(s.liveNodes)} ${n(s.liveTrees)} ${n(s.liveNativeTrees)}  ${s.phase}`);
+        }
+        const origins = Array.from(this.liveTrees.entries()).filter(([, v]) => v > 0).map(([k, v]) => `${k} ${v}`).join(', ');
+        lines.push(`  created: ${this.created.node} nodes, ${this.created.tree} trees, ${this.created.native} native trees`);
+        lines.push(`  live:    ${this.live.node} nodes, ${this.live.tree} trees (${origins || 'none'}), ${this.live.native} native trees`);
+        if (this.detachedTrees > 0) {
+            lines.push(`  warning: ${this.detachedTrees} detached tree(s) from remove() are still reachable; a rule or node reference is probably keeping them alive`);
+        }
+        for (const file of this.snapshots) {
+            lines.push(`  heap snapshot written to ${file}`);
+        }
+        return lines.join('\n');
+    }
+}
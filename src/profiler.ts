@@ -0,0 +1,185 @@
+import fs from 'fs';
+import { performance } from 'perf_hooks';
+
+/**
+ * A single Chrome trace event. Only "complete" events (ph: 'X') are emitted.
+ * Times are in microseconds, as required by the trace-event format.
+ */
+export interface TraceEvent {
+    name: string;
+    cat: string;
+    ph: 'X';
+    ts: number;
+    dur: number;
+    pid: number;
+    tid: number;
+    args?: Record<string, unknown>;
+}
+
+/** Aggregated timings for all spans sharing a category and name. */
+export interface SpanTotals {
+    name: string;
+    cat: string;
+    count: number;
+    /** Inclusive time in microseconds. */
+    total: number;
+    /** Exclusive time (total minus nested spans) in microseconds. */
+    self: number;
+    max: number;
+}
+
+interface OpenSpan {
+    name: string;
+    cat: string;
+    start: number;
+    childTime: number;
+    args?: Record<string, unknown>;
+}
+
+export interface ProfilerOptions {
+    /** Spans shorter than this (in microseconds) are aggregated but not written as trace events. */
+    minEventMicros?: number;
+    /** Only record spans in these categories; others are skipped (their time counts towards the enclosing span). */
+    categories?: string[];
+}
+
+/**
+ * Records timed spans of the transformation pipeline.
+ *
+ * Spans are written as Chrome trace-event JSON (loadable in chrome://tracing or
+ * Perfetto) and aggregated per category/name for a textual top-N summary.
+ * Instrumentation sites go through `Profiler.active`, so profiling costs a
+ * single null check when disabled.
+ */
+export class Profiler {
+    /** The profiler receiving spans, or null when profiling is disabled. */
+    static active: Profiler | null = null;
+
+    public events: TraceEvent[] = [];
+    public totals: Map<string, SpanTotals> = new Map();
+    public minEventMicros: number;
+    private categories: Set<string> | null;
+    private stack: (OpenSpan | null)[] = [];
+    private origin: number;
+
+    /**
+     * @param {ProfilerOptions} [options] - Recording options.
+     */
+    constructor(options: ProfilerOptions = {}) {
+        this.minEventMicros = options.minEventMicros ?? 1;
+        this.categories = options.categories ? new Set(options.categories) : null;
+        this.origin = performance.now();
+    }
+
+    /**
+     * Runs `fn` inside a span on the active profiler, or just runs it when profiling is off.
+     * @param {string} name - Span name (e.g. a macro name or rule description).
+     * @param {string} cat - Span category (e.g. 'macro', 'rule', 'tree-sitter').
+     * @param {function(): T} fn - The work to measure.
+     * @param {Record<string, unknown>} [args] - Extra data shown in the trace viewer.
+     * @returns {T} The result of `fn`.
+     */
+    static measure<T>(name: string, cat: string, fn: () => T, args?: Record<string, unknown>): T {
+        const profiler = Profiler.active;
+        if (!profiler) return fn();
+        profiler.begin(name, cat, args);
+        try {
+            return fn();
+        } finally {
+            profiler.end();
+        }
+    }
+
+    /**
+     * Opens a span. Every begin() must be balanced by an end().
+     * @param {string} name - Span name.
+     * @param {string} cat - Span category.
+     * @param {Record<string, unknown>} [args] - Extra data shown in the trace viewer.
+     */
+    begin(name: string, cat: string, args?: Record<string, unknown>): void {
+        if (this.categories && !this.categories.has(cat)) {
+            this.stack.push(null);
+            return;
+        }
+        this.stack.push({ name, cat, args, start: performance.now(), childTime: 0 });
+    }
+
+    /**
+     * Closes the innermost open span.
+     * @param {Record<string, unknown>} [args] - Extra data known only once the span has finished.
+     */
+    end(args?: Record<string, unknown>): void {
+        const span = this.stack.pop();
+        if (!span) return;
+
+        const dur = (performance.now() - span.start) * 1000;
+        for (let i = this.stack.length - 1; i >= 0; i--) {
+            const parent = this.stack[i];
+            if (parent) {
+                parent.childTime += dur;
+                break;
+            }
+        }
+
+        const key = `${span.cat}\0${span.name}`;
+        let totals = this.totals.get(key);
+        if (!totals) {
+            totals = { name: span.name, cat: span.cat, count: 0, total: 0, self: 0, max: 0 };
+            this.totals.set(key, totals);
+        }
+        totals.count++;
+        totals.total += dur;
+        totals.self += dur - span.childTime;
+        if (dur > totals.max) totals.max = dur;
+
+        if (dur >= this.minEventMicros) {
+            const event: TraceEvent = {
+                name: span.name,
+                cat: span.cat,
+                ph: 'X',
+                ts: (span.start - this.origin) * 1000,
+                dur,
+                pid: process.pid,
+                tid: 0
+            };
+            if (span.args || args) event.args = { ...span.args, ...args };
+            this.events.push(event);
+        }
+    }
+
+    /**
+     * Returns the recorded spans as a Chrome trace-event document.
+     * @returns {{ traceEvents: TraceEvent[], displayTimeUnit: string }}
+     */
+    toChromeTrace(): { traceEvents: TraceEvent[]; displayTimeUnit: string } {
+        return { traceEvents: this.events, displayTimeUnit: 'ms' };
+    }
+
+    /**
+     * Writes the Chrome trace-event JSON to disk.
+     * @param {string} filePath - Output path.
+     */
+    write(filePath: string): void {
+        fs.writeFileSync(filePath, JSON.stringify(this.toChromeTrace()));
+    }
+
+    /**
+     * Formats the most expensive span names, ordered by exclusive time.
+     * @param {number} [topN=20] - Number of rows to include.
+     * @returns {string} A fixed-width text table.
+     */
+    summary(topN: number = 20): string {
+        const rows = Array.from(this.totals.values()).sort((a, b) => b.self - a.self);
+        const grandTotal = rows.reduce((sum, r) => sum + r.self, 0);
+        const ms = (us: number) => (us / 1000).toFixed(2).padStart(10);
+
+        const lines = [
+            `[upp] profile: top ${Math.min(topN, rows.length)} of ${rows.length} spans by self time (${(grandTotal / 1000).toFixed(1)}ms profiled)`,
+            `   self ms   total ms     max ms    count  category     name`
+        ];
+        for (const r of rows.slice(0, topN)) {
+            lines.push(`${ms(r.self)} ${ms(r.total)} ${ms(r.max)} ${String(r.count).padStart(8)}  ${r.cat.padEnd(12)} ${r.name}`);
+        }
+        return lines.join('\n');
+    }
+}
@@ -4,9 +4,13 @@ import fs from 'fs';
 import path from 'path';
 import { UppHelpersC } from './upp_helpers_c.ts';
 import { UppHelpersBase } from './upp_helpers_base.ts';
-import { DiagnosticsManager } from './diagnostics.ts';
+import { DiagnosticsManager, LineIndex } from './diagnostics.ts';
 import { SourceTree, SourceNode } from './source_tree.ts';
 import { Transformer } from './transformer.ts';
+import { Profiler } from './profiler.ts';
+import { MemoryReport } from './mem_report.ts';
+import { FileLookupCache } from './fs_lookup.ts';
+import type { TransformStats, RuleCounters } from './stats.ts';
 import type { Tree, SyntaxNode } from 'tree-sitter';
 import type { DependencyCache } from './dependency_cache.ts';
 
@@ -26,6 +30,8 @@ export interface PendingRule<T extends string = string> {
     matcher: (node: SourceNode<T>, helpers: UppHelpersBase<any>) => boolean;
     callback: (node: SourceNode<T>, helpers: UppHelpersBase<any>) => MacroResult;
     oneShot?: boolean;
+    /** Matcher/hit counters, shared by all rules with the same description. */
+    counters?: RuleCounters;
     /** Tracks node instances that have already been produced as replacements by this rule, to prevent re-matching freshly-created identical subtrees. */
     substituted?: WeakSet<object>;
 }
@@ -52,6 +58,12 @@ export interface RegistryConfig {
     diagnostics?: DiagnosticsManager;
     suppress?: string[];
     comments?: boolean;
+    /** Counters to accumulate into, shared across registries so a build can report totals; omit to skip counting. */
+    stats?: TransformStats;
+    /** Release native tree-sitter trees after wrapping and share parsers (see `SourceTree.compact`). */
+    compact?: boolean;
+    /** Cache for include/dependency path resolution; defaults to a fresh cache for each top-level Registry. */
+    fileLookup?: FileLookupCache;
 }
 
 
@@ -90,12 +102,14 @@ class Registry {
 
     public stdPath: string | null;
     public includePaths: string[];
+    public fileLookup: FileLookupCache;
     public loadedDependencies: Map<string, string>;
     public shouldMaterializeDependency: boolean;
 
     public pendingRules: Set<PendingRule<any>>;
 
     public mainContext: RegistryContext | null;
+    public stats: TransformStats | null;
     public source?: string;
     private __tree?: SourceTree<any>;
     public get tree(): SourceTree<any> {
@@ -127,6 +141,8 @@ class Registry {
         }
 
         this.filePath = config.filePath || '';
+        this.stats = parentRegistry ? parentRegistry.stats : (config.stats || null);
+        if (!parentRegistry && config.compact !== undefined) SourceTree.compact = config.compact;
         this.diagnostics = config.diagnostics || new DiagnosticsManager(config);
 
         let lang: any = C;
@@ -139,12 +155,17 @@ class Registry {
 
         this.macros = new Map();
 
-        this.parser = new Parser();
-        this.parser.setLanguage(this.language);
+        if (SourceTree.compact) {
+            this.parser = SourceTree.sharedParser(this.language);
+        } else {
+            this.parser = new Parser();
+            this.parser.setLanguage(this.language);
+        }
 
 
         this.stdPath = config.stdPath || null;
         this.includePaths = config.includePaths || [];
+        this.fileLookup = parentRegistry ? parentRegistry.fileLookup : (config.fileLookup || new FileLookupCache());
         this.loadedDependencies = parentRegistry ? parentRegistry.loadedDependencies : new Map();
         this.shouldMaterializeDependency = false;
 
@@ -176,7 +197,7 @@ class Registry {
      */
     registerPendingRule(rule: Omit<PendingRule<any>, 'id'>): number {
         const id = ++Registry.ruleIdCounter;
-        const fullRule = { ...rule, id };
+        const fullRule = { ...rule, id, counters: this.stats?.ruleCounters(rule.description ?? 'anonymous') };
         this.pendingRules.add(fullRule);
         return id;
     }
@@ -233,7 +254,20 @@ class Registry {
                 throw new Error(`@${invocation.name} expected ${isTransformer ? macroDef.params.length - 1 : macroDef.params.length} arguments, found ${args.length}`);
             }
 
-            return macroFn(upp, console, upp.code.bind(upp), ...callArgs);
+            const profiler = Profiler.active;
+            if (!profiler) return macroFn(upp, console, upp.code.bind(upp), ...callArgs);
+
+            let site = filePath;
+            if (invocationNode?.tree) {
+                const { line, col } = DiagnosticsManager.getLineCol(invocationNode.tree.source, invocationNode.startIndex);
+                site = `${helpers.context?.originPath ?? filePath}:${line}:${col}`;
+            }
+            profiler.begin(`@${invocation.name}`, 'macro', { site });
+            try {
+                return macroFn(upp, console, upp.code.bind(upp), ...callArgs);
+            } finally {
+                profiler.end();
+            }
         } catch (e: any) {
             console.error(`[UPP] Error evaluating macro '${invocation.name}' at ${filePath}:`, e.message);
             throw e; // Rethrow to halt transformation
@@ -263,12 +297,13 @@ class Registry {
             try {
                 macro.fn = this.createMacroFunction(macro);
             } catch (e: any) {
+                const { line, col } = LineIndex.of(this.source || '').lineCol(startIndex);
                 this.diagnostics.reportError(
                     'UPP003',
                     `Syntax error in @${name} macro definition: ${e.message}`,
                     origin,
-                    (this.source?.slice(0, startIndex).match(/\n/g) || []).length + 1,
-                    startIndex - (this.source?.lastIndexOf('\n', startIndex) ?? 0),
+                    line,
+                    col,
                     this.source || null,
                     false // Don't exit yet, let it be reported
                 );
@@ -312,6 +347,10 @@ class Registry {
 
 
     loadDependency(file: string, originPath: string = 'unknown', parentHelpers: UppHelpersC | null = null): void {
+        Profiler.measure('loadDependency', 'registry', () => this._loadDependency(file, originPath, parentHelpers), { file, discovery: parentHelpers === null });
+    }
+
+    private _loadDependency(file: string, originPath: string, parentHelpers: UppHelpersC | null): void {
         let targetPath: string;
         if (path.isAbsolute(file)) {
             targetPath = file;
@@ -325,26 +364,14 @@ class Registry {
         if (previousPass === 'full') return;
         if (isDiscoveryOnly && previousPass === 'discovery') return;
 
-        if (!fs.existsSync(targetPath)) {
-            // Search include paths (from -I flags)
-            let found = false;
-            for (const inc of this.includePaths) {
-                const candidate = path.resolve(inc, file);
-                if (fs.existsSync(candidate)) {
-                    targetPath = candidate;
-                    found = true;
-                    break;
-                }
-            }
+        if (!this.fileLookup.exists(targetPath)) {
+            // Search include paths (from -I flags), then the std directory
+            const stdDir = this.stdPath || path.resolve(process.cwd(), 'std');
+            const found = this.fileLookup.resolve(file, [...this.includePaths, stdDir]);
             if (!found) {
-                const stdDir = this.stdPath || path.resolve(process.cwd(), 'std');
-                const stdPath = path.resolve(stdDir, file);
-                if (fs.existsSync(stdPath)) {
-                    targetPath = stdPath;
-                } else {
-                    throw new Error(`Dependency not found: ${file} (tried ${targetPath} and ${stdPath})`);
-                }
+                throw new Error(`Dependency not found: ${file} (tried ${targetPath} and ${path.resolve(stdDir, file)})`);
             }
+            targetPath = found;
         }
 
         if (this.config.cache && this.config.cache.get(targetPath) && !isDiscoveryOnly) {
@@ -352,6 +379,7 @@ class Registry {
 
             // Only use cache if it's authoritative, or if we don't care about authority (isDiscoveryOnly handled above)
             if (cached && cached.isAuthoritative) {
+                if (this.stats) this.stats.dependencyCacheHits++;
                 // Replay macros
                 for (const macro of cached.macros) {
                     this.registerMacro(macro.name, macro.params, macro.body, macro.language, macro.origin, macro.startIndex);
@@ -371,6 +399,7 @@ class Registry {
             }
         }
 
+        if (!isDiscoveryOnly && this.stats) this.stats.dependencyCacheMisses++;
         this.loadedDependencies.set(targetPath, isDiscoveryOnly ? 'discovery' : 'full');
 
         const source = fs.readFileSync(targetPath, 'utf8');
@@ -445,7 +474,9 @@ class Registry {
      * Delegates the actual pipeline to the Transformer class.
      */
     transform(source: string, originPath: string = 'unknown', parentHelpers: UppHelpersC | null = null): string {
-        return new Transformer(this).run(source, originPath, parentHelpers);
+        const output = Profiler.measure('transform', 'registry', () => new Transformer(this).run(source, originPath, parentHelpers), { file: originPath });
+        MemoryReport.active?.sample(`transform ${path.basename(originPath)}`);
+        return output;
     }
 
     /**
@@ -470,13 +501,14 @@ class Registry {
      * Phase 2 (side effects): register macros, load @include dependencies.
      */
     prepareSource(source: string, originPath?: string): { cleanSource: string; invocations: Invocation[] } {
+        return Profiler.measure('prepareSource', 'registry', () => this._prepareSource(source, originPath), { file: originPath, bytes: source.length });
+    }
+
+    private _prepareSource(source: string, originPath?: string): { cleanSource: string; invocations: Invocation[] } {
         // --- Phase 1: Pure source analysis ---
         const definerRegex = /^\s*@define\s+(\w+)\s*\(([^)]*)\)\s*\{/gm;
         let cleanSource = source;
-        const tree = this.parser.parse((index: number) => {
-            if (index >= source.length) return null;
-            return source.slice(index, index + 4096);
-        });
+        const tree = SourceTree.parse(this.parser, source, 'prepareSource', this.stats);
 
         const defines: Array<{ index: number; length: number; original: string; name: string; params: string[]; body: string }> = [];
         let match;
@@ -506,10 +538,7 @@ class Registry {
             cleanSource = cleanSource.slice(0, def.index) + replaced + cleanSource.slice(def.index + def.length);
         }
 
-        const cleanTree = this.parser.parse((index: number) => {
-            if (index >= cleanSource.length) return null;
-            return cleanSource.slice(index, index + 4096);
-        });
+        const cleanTree = SourceTree.parse(this.parser, cleanSource, 'prepareSource', this.stats);
         const invocations = this.findInvocations(cleanSource, cleanTree);
         for (let i = invocations.length - 1; i >= 0; i--) {
             const inv = invocations[i];
@@ -585,10 +614,8 @@ class Registry {
         const invs: Invocation[] = [];
         const regex = /(?<![\/*])@(\w+)(\s*\(([^)]*)\))?/g;
         let match;
-        const currentTree = tree || this.parser.parse((index: number) => {
-            if (index >= source.length) return null;
-            return source.slice(index, index + 4096);
-        });
+        const currentTree = tree || SourceTree.parse(this.parser, source, 'findInvocations', this.stats);
+        let lines: LineIndex | null = null;
 
         while ((match = regex.exec(source)) !== null) {
 
@@ -605,13 +632,15 @@ class Registry {
 
             const name = match[1].trim();
             const args = match[3] ? match[3].trim().split(',').map(s => s.trim()).filter(Boolean) : [];
+            lines ??= new LineIndex(source);
+            const { line, col } = lines.lineCol(match.index);
             invs.push({
                 name,
                 args,
                 startIndex: match.index,
                 endIndex: match.index + match[0].length,
-                line: (source.slice(0, match.index).match(/\n/g) || []).length + 1,
-                col: match.index - source.lastIndexOf('\n', match.index)
+                line,
+                col
             });
         }
         return invs;
@@ -2,6 +2,9 @@ import Parser from 'tree-sitter';
 import type { Tree, SyntaxNode } from 'tree-sitter';
 
 import type { Language } from './types.ts';
+import { Profiler } from './profiler.ts';
+import type { TransformStats } from './stats.ts';
+import { MemoryReport } from './mem_report.ts';
 
 /**
  * Represents a source file as a manageable tree of nodes, 
@@ -11,35 +14,110 @@ export class SourceTree<NodeTypes extends string = string> {
     public source: string;
     public language: Language;
     public parser: Parser;
-    public tree: Tree;
+    /** The native tree-sitter tree, or null once released in compact mode. */
+    public tree: Tree | null;
     public nodeCache: Map<number | string, SourceNode<NodeTypes>>;
     public root: SourceNode<NodeTypes>;
     public onMutation: (() => void) | null = null;
+    /** Counters for parses, wrapped nodes and edits; null unless stats were requested. */
+    public stats: TransformStats | null;
+
+    /**
+     * Compact mode: release each native tree-sitter tree as soon as its nodes are
+     * wrapped, and share one parser per language. SourceNode copies everything it
+     * needs from the native node at construction, so only the wrappers are kept.
+     */
+    static compact: boolean = false;
+    private static treeSerial: number = 0;
+    private static parsers: WeakMap<object, Parser> = new WeakMap();
+    /**
+     * Prefix for node-cache keys in compact mode. Native node ids are addresses,
+     * which can be reused once a tree is freed, and nodes keep their keys when
+     * they migrate between trees, so keys are qualified by the tree they came from.
+     */
+    private keyPrefix: string | null;
 
     /**
      * @param {string} source Initial source code text.
      * @param {Language} language Tree-sitter Language object.
+     * @param {string} [origin='source'] Why the tree was created (e.g. 'fragment', 'remove', 'clone'); used for instrumentation.
+     * @param {TransformStats | null} [stats=null] Counters to record this tree's work against.
      */
-    constructor(source: string, language: Language) { // language is tree-sitter Language
+    constructor(source: string, language: Language, origin: string = 'source', stats: TransformStats | null = null) { // language is tree-sitter Language
         if (typeof source !== 'string') {
             throw new Error(`SourceTree expects string source, got ${typeof source}`);
         }
         this.source = source;
         this.language = language;
-        this.parser = new Parser();
-        this.parser.setLanguage(language);
+        this.stats = stats;
+        if (SourceTree.compact) {
+            this.parser = SourceTree.sharedParser(language);
+            this.keyPrefix = `${++SourceTree.treeSerial}:`;
+        } else {
+            this.parser = new Parser();
+            this.parser.setLanguage(language);
+            this.keyPrefix = null;
+        }
 
         // Initial parse
-        this.tree = this.parser.parse((index: number) => {
-            if (index >= source.length) return null;
-            return source.slice(index, index + 4096);
-        });
+        const tree = SourceTree.parse(this.parser, source, origin, stats);
+        this.tree = tree;
+        MemoryReport.active?.trackTree(this, tree, origin);
 
         /** @type {Map<string, SourceNode>} Map of TreeSitterNode.id -> SourceNode */
         this.nodeCache = new Map();
 
         /** @type {SourceNode} The root node of the tree. */
-        this.root = this.wrap(this.tree.rootNode) as SourceNode<NodeTypes>;
+        this.root = this.wrap(tree.rootNode) as SourceNode<NodeTypes>;
+        stats?.observeNodeCache(this.nodeCache.size);
+
+        if (SourceTree.compact) this.tree = null;
+    }
+
+    /**
+     * Returns the parser shared by all trees of a language in compact mode.
+     * @param {Language} language Tree-sitter Language object.
+     * @returns {Parser}
+     */
+    static sharedParser(language: Language): Parser {
+        let parser = SourceTree.parsers.get(language);
+        if (!parser) {
+            parser = new Parser();
+            parser.setLanguage(language);
+            SourceTree.parsers.set(language, parser);
+        }
+        return parser;
+    }
+
+    /**
+     * Returns the node-cache key for a Tree-sitter node of this tree.
+     * @param {SyntaxNode} tsNode The Tree-sitter node.
+     * @returns {number | string}
+     */
+    keyOf(tsNode: SyntaxNode): number | string {
+        return this.keyPrefix === null ? tsNode.id : this.keyPrefix + tsNode.id;
+    }
+
+    /**
+     * Parses source text in 4K chunks, recording the parse on the active profiler.
+     * @param {Parser} parser A parser with its language already set.
+     * @param {string} source The text to parse.
+     * @param {string} site The call site, reported in profiles (e.g. 'fragment', 'pattern').
+     * @param {TransformStats | null} [stats=null] Counters to record the parse against.
+     * @returns {Tree}
+     */
+    static parse(parser: Parser, source: string, site: string, stats: TransformStats | null = null): Tree {
+        stats?.countParse(site);
+        const profiler = Profiler.active;
+        profiler?.begin('parse', 'tree-sitter', { site, bytes: source.length });
+        try {
+            return parser.parse((index: number) => {
+                if (index >= source.length) return null;
+                return source.slice(index, index + 4096);
+            });
+        } finally {
+            profiler?.end();
+        }
     }
 
     /**
@@ -51,15 +129,17 @@ export class SourceTree<NodeTypes extends string = string> {
      */
     wrap<T extends NodeTypes>(tsNode: SyntaxNode | null, parent: SourceNode<NodeTypes> | null = null, fieldName: string | null = null): SourceNode<T> | null {
         if (!tsNode) return null;
-        if (this.nodeCache.has(tsNode.id)) {
-            const node = this.nodeCache.get(tsNode.id)! as SourceNode<T>;
+        const key = this.keyOf(tsNode);
+        if (this.nodeCache.has(key)) {
+            const node = this.nodeCache.get(key)! as SourceNode<T>;
             if (parent) node.parent = parent;
             if (fieldName) node.fieldName = fieldName;
             return node;
         }
 
         const node = new SourceNode(this, tsNode, parent, fieldName) as SourceNode<T>;
-        this.nodeCache.set(tsNode.id, node);
+        this.nodeCache.set(key, node);
+        if (this.stats) this.stats.nodesWrapped++;
         return node;
     }
 
@@ -70,19 +150,27 @@ export class SourceTree<NodeTypes extends string = string> {
      * @param {string} newText The replacement text.
      */
     edit(start: number, end: number, newText: string): void {
-        const oldLen = end - start;
-        const newLen = newText.length;
-        const delta = newLen - oldLen;
-
-        // 1. Update source string
-        this.source = this.source.slice(0, start) + newText + this.source.slice(end);
-
-        // 2. Notify active nodes to shift their offsets
-        const nodes = Array.from(this.nodeCache.values());
-        for (const node of nodes) {
-            node.handleEdit(start, end, delta);
+        const profiler = Profiler.active;
+        profiler?.begin('SourceTree.edit', 'tree', { removed: end - start, inserted: newText.length });
+
+        let nodes: SourceNode<NodeTypes>[] = [];
+        try {
+            const oldLen = end - start;
+            const newLen = newText.length;
+            const delta = newLen - oldLen;
+            this.stats?.countEdit(this.source.length - end + newLen);
+
+            // 1. Update source string
+            this.source = this.source.slice(0, start) + newText + this.source.slice(end);
+
+            // 2. Notify active nodes to shift their offsets
+            nodes = Array.from(this.nodeCache.values());
+            for (const node of nodes) {
+                node.handleEdit(start, end, delta);
+            }
+        } finally {
+            profiler?.end({ nodes: nodes.length });
         }
-
         if (this.onMutation) this.onMutation();
     }
 
@@ -106,9 +194,10 @@ export class SourceTree<NodeTypes extends string = string> {
      * Tries to parse as valid code; if it fails, wraps in a dummy function to parse statements/expressions.
      * @param {string | SourceNode<any> | SourceTree<any>} code The text fragment to parse.
      * @param {Language} language Tree-sitter language object.
+     * @param {TransformStats | null} [stats=null] Counters to record the fragment's parses against.
      * @returns {SourceNode<NodeTypes>}
      */
-    static fragment<NodeTypes extends string = string>(code: string | SourceNode<any> | SourceTree<any>, language: Language): SourceNode<NodeTypes> {
+    static fragment<NodeTypes extends string = string>(code: string | SourceNode<any> | SourceTree<any>, language: Language, stats: TransformStats | null = null): SourceNode<NodeTypes> {
         if (typeof code !== 'string') {
             if (code instanceof SourceNode) return code;
             if (code instanceof SourceTree) return code.root;
@@ -121,7 +210,7 @@ export class SourceTree<NodeTypes extends string = string> {
         const keywords = ['if', 'else', 'for', 'while', 'do', 'switch', 'case', 'return', 'break', 'continue', 'void', 'int', 'char', 'float', 'double', 'struct', 'union', 'enum', 'typedef', 'static', 'extern', 'const', 'volatile', 'inline'];
         if (idRegex.test(trimmed) && !keywords.includes(trimmed)) {
             const dummy = `void* __tmp = (void*)${trimmed};`;
-            const fragTree = new SourceTree(dummy, language);
+            const fragTree = new SourceTree(dummy, language, 'fragment', stats);
             // We want the identifier that matches our text, not the dummy '__tmp'
             const idNode = fragTree.root.find(n => (n.type === 'identifier' || n.type === 'type_identifier') && n.text === trimmed)[0];
             if (idNode) {
@@ -130,12 +219,14 @@ export class SourceTree<NodeTypes extends string = string> {
             }
         }
 
-        const parser = new Parser();
-        parser.setLanguage(language);
-        let tree = parser.parse((index: number) => {
-            if (index >= code.length) return null;
-            return code.slice(index, index + 4096);
-        });
+        let parser: Parser;
+        if (SourceTree.compact) {
+            parser = SourceTree.sharedParser(language);
+        } else {
+            parser = new Parser();
+            parser.setLanguage(language);
+        }
+        let tree = SourceTree.parse(parser, code, 'fragment', stats);
 
         let hasError = false;
         if (typeof tree.rootNode.hasError === 'function') {
@@ -160,13 +251,13 @@ export class SourceTree<NodeTypes extends string = string> {
             }
 
             if (isTopLevel && root.childCount > 0) {
-                return new SourceTree(code, language).root as SourceNode<NodeTypes>;
+                return new SourceTree(code, language, 'fragment', stats).root as SourceNode<NodeTypes>;
             }
         }
 
         // 2. Try wrapping in a function (for statements/expressions)
         const wrappedCode = `void __frag() { ${code} }`;
-        const wrappedTree = new SourceTree(wrappedCode, language);
+        const wrappedTree = new SourceTree(wrappedCode, language, 'fragment', stats);
 
         // Guarantee no ERROR nodes in the wrapped fragment
         if (wrappedTree.root.toString().includes("ERROR")) {
@@ -182,21 +273,21 @@ export class SourceTree<NodeTypes extends string = string> {
         const innerNodes = body.children.slice(1, -1);
 
         if (innerNodes.length === 0) {
-            return new SourceTree("", language).root as SourceNode<NodeTypes>;
+            return new SourceTree("", language, 'fragment', stats).root as SourceNode<NodeTypes>;
         }
 
         if (innerNodes.length === 1) {
             // Return just the single node, but it must be migrated to its own tree to be independent
             const node = innerNodes[0];
             const text = node.text;
-            const fragTree = new SourceTree(text, language);
+            const fragTree = new SourceTree(text, language, 'fragment', stats);
             // Return the first child of the translation_unit (the actual node)
             return fragTree.root.children[0] || fragTree.root as SourceNode<NodeTypes>;
         }
 
         // Multiple nodes? Create a new SourceTree with just those nodes' text.
         const combinedText = innerNodes.map(n => n.text).join('\n');
-        const finalTree = new SourceTree(combinedText, language);
+        const finalTree = new SourceTree(combinedText, language, 'fragment', stats);
         return finalTree.root as SourceNode<NodeTypes>;
     }
 
@@ -228,6 +319,8 @@ export class SourceTree<NodeTypes extends string = string> {
             targetTree.nodeCache.set(id, node);
         }
 
+        targetTree.stats?.observeNodeCache(targetTree.nodeCache.size);
+
         // 2. Clear our cache (we are now empty/invalid logic wise, but nodes are safe)
         this.nodeCache.clear();
     }
@@ -263,8 +356,9 @@ export class SourceNode<T extends string = string> {
         if (!tsNode || !tree) {
             throw new Error("SourceNode must be created with a Tree-sitter node.");
         }
+        MemoryReport.active?.trackNode(this);
         this.tree = tree;
-        this._cacheKey = tsNode.id;
+        this._cacheKey = tree.keyOf(tsNode);
         this.type = tsNode.type as T;
         this.startIndex = tsNode.startIndex;
         this.endIndex = tsNode.endIndex;
@@ -451,7 +545,7 @@ export class SourceNode<T extends string = string> {
         const cachedText = this.text;
 
         // 2. Create new holding tree with text.
-        const newTree = new SourceTree<any>(cachedText, this.tree.language);
+        const newTree = new SourceTree<any>(cachedText, this.tree.language, 'remove', this.tree.stats);
 
         // 3. Migrate `this` node into newTree at offset 0.
         const oldStartIndex = this.startIndex;
@@ -535,7 +629,7 @@ export class SourceNode<T extends string = string> {
             } else if (start === -1) {
                 // Truly invalidated node with no re-attachment context
                 return (typeof content === 'string')
-                    ? SourceTree.fragment<any>(content, this.tree.language)
+                    ? SourceTree.fragment<any>(content, this.tree.language, this.tree.stats)
                     : (content as any);
             }
         } else {
@@ -577,7 +671,7 @@ export class SourceNode<T extends string = string> {
         snapshotIdentity(oldChildren);
 
         if (typeof newNode === 'string') {
-            newNode = SourceTree.fragment<any>(newNode, this.tree.language);
+            newNode = SourceTree.fragment<any>(newNode, this.tree.language, this.tree.stats);
         }
 
         let newText = "";
@@ -709,7 +803,7 @@ export class SourceNode<T extends string = string> {
             newNode = newNode.filter(x => x !== null && x !== undefined);
         }
         if (typeof newNode === 'string') {
-            newNode = SourceTree.fragment<any>(newNode, this.tree.language);
+            newNode = SourceTree.fragment<any>(newNode, this.tree.language, this.tree.stats);
         }
         let text = "";
         if (Array.isArray(newNode)) {
@@ -771,7 +865,7 @@ export class SourceNode<T extends string = string> {
         const tree = this.tree;
         let newNode: SourceNode<any> | SourceTree<any> | string | Array<SourceNode<any> | string> = content;
         if (typeof newNode === 'string') {
-            newNode = SourceTree.fragment<any>(newNode, this.tree.language);
+            newNode = SourceTree.fragment<any>(newNode, this.tree.language, this.tree.stats);
         }
         let text = "";
         if (Array.isArray(newNode)) {
@@ -948,7 +1042,7 @@ export class SourceNode<T extends string = string> {
      */
     append(newNode: SourceNode<any> | SourceTree<any> | string): SourceNode<any> | SourceNode<any>[] {
         if (typeof newNode === 'string') {
-            newNode = SourceTree.fragment<any>(newNode, this.tree.language);
+            newNode = SourceTree.fragment<any>(newNode, this.tree.language, this.tree.stats);
         }
         const text = (newNode as any).text;
 
@@ -965,7 +1059,7 @@ export class SourceNode<T extends string = string> {
      * @returns {SourceNode<T>} A new node instance with the same content but fresh identity.
      */
     public clone(): SourceNode<T> {
-        const tempTree = new SourceTree<any>(this.text, this.tree.language);
+        const tempTree = new SourceTree<any>(this.text, this.tree.language, 'clone', this.tree.stats);
         const clonedNode = tempTree.root as any;
 
         const propagateData = (n: SourceNode<any>) => {
@@ -0,0 +1,130 @@
+/** Per-rule counters, shared by every registration of a rule with the same description. */
+export interface RuleCounters {
+    matcherCalls: number;
+    hits: number;
+}
+
+/**
+ * Low-overhead counters describing the work done by a transformation.
+ *
+ * Registry-level counters are recorded against `registry.stats`. Work done inside
+ * SourceTree (wrapping, parsing, editing) is recorded against `tree.stats`, which
+ * trees inherit from the registry that created them. Both are null when no
+ * counters were requested.
+ */
+export class TransformStats {
+    public nodesWrapped: number = 0;
+    public nodeCachePeak: number = 0;
+    public parses: Record<string, number> = {};
+    public edits: number = 0;
+    public bytesMoved: number = 0;
+    public walkerVisits: number = 0;
+    public walkerRevisits: number = 0;
+    public maxIterationHits: number = 0;
+    public dependencyCacheHits: number = 0;
+    public dependencyCacheMisses: number = 0;
+    /** Milliseconds spent building registries and transforming, excluding the C compiler. */
+    public transformMs: number = 0;
+    public rules: Map<string, RuleCounters> = new Map();
+
+    /**
+     * Records a tree-sitter parse.
+     * @param {string} site - The call site (e.g. 'fragment', 'remove', 'clone', 'pattern').
+     */
+    countParse(site: string): void {
+        this.parses[site] = (this.parses[site] || 0) + 1;
+    }
+
+    /**
+     * Records a SourceTree edit.
+     * @param {number} bytesMoved - Characters shifted or inserted by the splice.
+     */
+    countEdit(bytesMoved: number): void {
+        this.edits++;
+        this.bytesMoved += bytesMoved;
+    }
+
+    /**
+     * Records the size of a node cache, keeping the peak.
+     * @param {number} size - Current number of cached nodes in a tree.
+     */
+    observeNodeCache(size: number): void {
+        if (size > this.nodeCachePeak) this.nodeCachePeak = size;
+    }
+
+    /**
+     * Returns the counters for a rule, creating them on first use.
+     * Rules hold on to the returned object so the hot path never does a lookup.
+     * @param {string} description - The rule description.
+     * @returns {RuleCounters}
+     */
+    ruleCounters(description: string): RuleCounters {
+        let counters = this.rules.get(description);
+        if (!counters) {
+            counters = { matcherCalls: 0, hits: 0 };
+            this.rules.set(description, counters);
+        }
+        return counters;
+    }
+
+    /** @returns {number} Total parses across all call sites. */
+    get totalParses(): number {
+        return Object.values(this.parses).reduce((a, b) => a + b, 0);
+    }
+
+    /** @returns {number} Total matcher invocations across all rules. */
+    get totalMatcherCalls(): number {
+        let total = 0;
+        for (const r of this.rules.values()) total += r.matcherCalls;
+        return total;
+    }
+
+    /**
+     * Serializable snapshot of all counters.
+     * @returns {Object}
+     */
+    toJSON(): Record<string, unknown> {
+        return {
+            nodesWrapped: this.nodesWrapped,
+            nodeCachePeak: this.nodeCachePeak,
+            parses: { ...this.parses },
+            edits: this.edits,
+            bytesMoved: this.bytesMoved,
+            walkerVisits: this.walkerVisits,
+            walkerRevisits: this.walkerRevisits,
+            maxIterationHits: this.maxIterationHits,
+            dependencyCacheHits: this.dependencyCacheHits,
+            dependencyCacheMisses: this.dependencyCacheMisses,
+            transformMs: Math.round(this.transformMs),
+            rules: Object.fromEntries(this.rules)
+        };
+    }
+
+    /**
+     * Formats the counters as a text report.
+     * @param {number} [topRules=20] - Number of rules to list, ordered by matcher calls.
+     * @returns {string}
+     */
+    format(topRules: number = 20): string {
+        const n = (v: number) => String(v).padStart(10);
+        const parseSites = Object.entries(this.parses).sort((a, b) => b[1] - a[1]).map(([k, v]) => `${k} ${v}`).join(', ');
+        const lines = [
+            `[upp] stats:`,
+            `  nodes wrapped        ${n(this.nodesWrapped)}`,
+            `  node cache peak      ${n(this.nodeCachePeak)}`,
+            `  parses               ${n(this.totalParses)}  (${parseSites})`,
+            `  edits                ${n(this.edits)}  (${this.bytesMoved} bytes moved)`,
+            `  walker visits        ${n(this.walkerVisits)}  (${this.walkerRevisits} revisits)`,
+            `  MAX_ITERATIONS hits  ${n(this.maxIterationHits)}`,
+            `  dependency cache     ${n(this.dependencyCacheHits)}  hits, ${this.dependencyCacheMisses} misses`,
+            `  transform time       ${n(Math.round(this.transformMs))}  ms`,
+            `  rules                ${n(this.rules.size)}  (${this.totalMatcherCalls} matcher calls)`,
+            `  ${'matcher'.padStart(10)} ${'hits'.padStart(10)}  rule`
+        ];
+        const rules = Array.from(this.rules.entries()).sort((a, b) => b[1].matcherCalls - a[1].matcherCalls);
+        for (const [name, r] of rules.slice(0, topRules)) {
+            lines.push(`  ${n(r.matcherCalls)} ${n(r.hits)}  ${name}`);
+        }
+        return lines.join('\n');
+    }
+}
@@ -1,7 +1,10 @@
+import path from 'path';
 import { UppHelpersC } from './upp_helpers_c.ts';
 import { UppHelpersBase } from './upp_helpers_base.ts';
 import { SourceTree, SourceNode } from './source_tree.ts';
 import type { Registry, RegistryContext } from './registry.ts';
+import { Profiler } from './profiler.ts';
+import { MemoryReport } from './mem_report.ts';
 
 /**
  * Encapsulates the transformation pipeline for a single source file.
@@ -24,7 +27,7 @@ export class Transformer {
 
     // Initialize tree and helpers early so dependencies loaded during
     // prepareSource() can see this registry's tree via parentRegistry.
-    registry.tree = new SourceTree<any>(source, registry.language as any);
+    registry.tree = new SourceTree<any>(source, registry.language as any, 'transform', registry.stats);
     if (!registry.tree) throw new Error("Could not create source tree for transformation.");
 
     registry.tree.onMutation = () => registry.markMutated();
@@ -35,7 +38,7 @@ export class Transformer {
 
     // Rebuild tree if preprocessing mutated the raw text
     if (cleanSource !== source) {
-      registry.tree = new SourceTree<any>(cleanSource || "", registry.language as any);
+      registry.tree = new SourceTree<any>(cleanSource || "", registry.language as any, 'transform', registry.stats);
     }
 
     const helpers = new UppHelpersC(registry, parentHelpers) as any;
@@ -71,9 +74,21 @@ export class Transformer {
     const walkerDone = new WeakSet<SourceNode<any>>();
     context.walkerDone = walkerDone;
 
+    const stats = registry.stats;
+    const memReport = MemoryReport.active;
+    // Revisits are only tracked when someone asked for the counters
+    const visited = stats ? new WeakSet<SourceNode<any>>() : null;
+    let visits = 0;
     const it = this.walk(registry.tree.root, walkerDone);
     let newSubTree: SourceNode<any> | undefined = undefined;
     for (let { value, done } = it.next(); value && !done; { value, done } = it.next(newSubTree)) {
+      visits++;
+      if (memReport && visits % 10000 === 0) memReport.sample(`walk ${path.basename(originPath)}`);
+      if (stats) {
+        stats.walkerVisits++;
+        if (visited!.has(value)) stats.walkerRevisits++;
+        else visited!.add(value);
+      }
       newSubTree = this.transformNode(value, helpers, context);
     }
 
@@ -124,6 +139,7 @@ export class Transformer {
   private transformNode(node: SourceNode<any>, helpers: UppHelpersBase<any>, context: RegistryContext): SourceNode<any> | undefined {
     let iterations = 0;
     const MAX_ITERATIONS = 50;
+    const profiler = Profiler.active;
     while (iterations < MAX_ITERATIONS) {
       iterations++;
       if (!node || node.startIndex === -1 || !node.isValid) {
@@ -137,10 +153,29 @@ export class Transformer {
           // as a replacement by this same rule, skip it.
           if (rule.substituted?.has(node)) continue;
 
-          if (rule.matcher(node, helpers)) {
+          const ruleName = profiler ? (rule.description ?? `rule#${rule.id}`) : '';
+          let matched: boolean;
+          profiler?.begin(ruleName, 'matcher');
+          try {
+            matched = rule.matcher(node, helpers);
+          } finally {
+            profiler?.end();
+          }
+          if (rule.counters) {
+            rule.counters.matcherCalls++;
+            if (matched) rule.counters.hits++;
+          }
+
+          if (matched) {
             const oldContext = helpers.contextNode;
             helpers.contextNode = node;
-            const substitution = rule.callback(node, helpers);
+            let substitution;
+            profiler?.begin(ruleName, 'callback', { node: node.type });
+            try {
+              substitution = rule.callback(node, helpers);
+            } finally {
+              profiler?.end();
+            }
             helpers.contextNode = oldContext;
 
             if (substitution === undefined || substitution === node) {
@@ -195,6 +230,7 @@ export class Transformer {
     }
 
     if (iterations >= MAX_ITERATIONS) {
+      if (this.registry.stats) this.registry.stats.maxIterationHits++;
       console.warn(`[UPP] Maximum substitution iterations (${MAX_ITERATIONS}) reached for node of type ${node.type}. Possible infinite generation loop.`);
     }
   }
@@ -1,6 +1,7 @@
 import { SourceNode, SourceTree } from './source_tree.ts';
 import type { Invocation, Registry, RegistryContext } from './registry.ts';
 import { PatternMatcher } from './pattern_matcher.ts';
+import { Profiler } from './profiler.ts';
 import Parser from 'tree-sitter';
 import type { MacroResult, AnySourceNode, InterpolationValue } from './types.ts';
 
@@ -42,6 +43,9 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
     get isAuthoritative(): boolean { return this.registry.isAuthoritative; }
     set isAuthoritative(v: boolean) { this.registry.isAuthoritative = v; }
 
+    /** Whether rule descriptions are reported anywhere (a profile or --stats), so costly ones are worth building. */
+    protected get describesRules(): boolean { return Profiler.active !== null || this.registry.stats !== null; }
+
     constructor(registry: Registry, parentHelpers: UppHelpersBase<LanguageNodeTypes> | null = null) {
         this.registry = registry;
         this._parentHelpers = parentHelpers;
@@ -55,12 +59,18 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
 
         this.stdPath = registry ? registry.stdPath : null;
 
-        // Use a dedicated parser for patterns to avoid invalidating the main registry parser/tree
-        const patternParser = new Parser();
-        if (registry && registry.language) {
-            patternParser.setLanguage(registry.language as any);
+        // Use a dedicated parser for patterns to avoid invalidating the main registry parser/tree.
+        // Compact mode shares one parser per language instead; no native trees are kept alive there.
+        let patternParser: Parser;
+        if (SourceTree.compact && registry && registry.language) {
+            patternParser = SourceTree.sharedParser(registry.language);
+        } else {
+            patternParser = new Parser();
+            if (registry && registry.language) {
+                patternParser.setLanguage(registry.language as any);
+            }
         }
-        this.matcher = new PatternMatcher((src) => patternParser.parse(src), registry ? registry.language as any : null);
+        this.matcher = new PatternMatcher((src) => SourceTree.parse(patternParser, src, 'pattern', registry ? registry.stats : null), registry ? registry.language as any : null);
     }
 
 
@@ -113,7 +123,7 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
 
         // @ts-ignore - reaching into internals for tree cloning
         const SourceTreeCtor: any = this.registry.tree!.constructor;
-        const fragment = SourceTreeCtor.fragment(cleanText, this.registry.language);
+        const fragment = SourceTreeCtor.fragment(cleanText, this.registry.language, this.registry.stats);
         if (!fragment) {
             throw new Error("upp.code: Failed to parse code fragment");
         }
@@ -287,6 +297,7 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
         }
 
         this.registry.registerPendingRule({
+            description: `withNode(${targetNode.type})`,
             matcher: (n) => n === targetNode,
             callback: (n, h) => callback(n as SourceNode<LanguageNodeTypes>, h as UppHelpersBase<LanguageNodeTypes>),
             oneShot: true
@@ -397,6 +408,7 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
         const patterns = Array.isArray(pattern) ? pattern : [pattern];
 
         this.registry.registerPendingRule({
+            description: this.describesRules ? `withMatch(${patterns.join(' | ')})` : undefined,
             matcher: (n, h) => {
                 // If scope is a root node (translation_unit), match globally
                 // This allows header-registered rules to apply to the main file
@@ -441,6 +453,7 @@ abstract class UppHelpersBase<LanguageNodeTypes extends string> {
     */
     withPattern(nodeType: LanguageNodeTypes, matcher: (node: SourceNode<LanguageNodeTypes>, helpers: UppHelpersBase<LanguageNodeTypes>) => boolean, callback: (node: SourceNode<LanguageNodeTypes>, helpers: UppHelpersBase<LanguageNodeTypes>) => MacroResult): void {
         this.registry.registerPendingRule({
+            description: `withPattern(${nodeType})`,
             matcher: (node: SourceNode<LanguageNodeTypes>, helpers: UppHelpersBase<any>) => {
                 if (node.type !== nodeType) return false;
                 return matcher(node, helpers as UppHelpersBase<LanguageNodeTypes>);
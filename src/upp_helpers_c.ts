@@ -1,6 +1,7 @@
 import { UppHelpersBase } from './upp_helpers_base.ts';
 import type { Registry, RegistryContext } from './registry.ts';
 import { SourceNode } from './source_tree.ts';
+import { CInterpreter, ConstEvalError } from './c_interpreter.ts';
 import type { MacroResult, AnySourceNode, InterpolationValue } from './types.ts';
 
 export class FunctionSignature {
@@ -577,6 +578,29 @@ export class UppHelpersC extends UppHelpersBase<CNodeTypes> {
     );
   }
 
+  /**
+   * Evaluates a call of a pure function at transpile time.
+   * Calls made by the function resolve to other function definitions in this file.
+   * @param {SourceNode<CNodeTypes>} fnNode - The function_definition being called.
+   * @param {SourceNode<CNodeTypes>[]} args - The argument expressions.
+   * @param {number} [stepLimit] - Maximum number of statements and expressions to evaluate.
+   * @returns {string | null} The result as a C literal, or null if the call cannot be evaluated.
+   */
+  constEval(fnNode: SourceNode<CNodeTypes>, args: SourceNode<CNodeTypes>[], stepLimit?: number): string | null {
+    const resolveFunction = (name: string, callSite: SourceNode<any>): SourceNode<any> | null => {
+      const def = this.findDefinitionOrNull(callSite);
+      if (def?.type === 'function_definition') return def;
+      // A prototype shadows the definition for lookup; find the body it declares
+      return this.root?.children.find(c => c.type === 'function_definition' && this.getFunctionSignature(c).name === name) ?? null;
+    };
+    try {
+      return new CInterpreter({ resolveFunction, stepLimit }).evaluateCall(fnNode, args);
+    } catch (e) {
+      if (e instanceof ConstEvalError) return null;
+      throw e;
+    }
+  }
+
   /**
    * Finds the definition for a node or name, returning null if not found.
    * @param {SourceNode<any>|string} target - The identifier node, a container node, or a scoping node (if name is provided).
@@ -843,6 +867,7 @@ export class UppHelpersC extends UppHelpersBase<CNodeTypes> {
     const firedAt = new Set<number>();
 
     this.registry.registerPendingRule({
+      description: `withReferences(${definitionName})`,
       matcher: (node, helpers) => {
         if (node.type !== 'identifier' && node.type !== 'type_identifier' && node.type !== 'field_identifier') return false;
         if (node.text !== definitionName) return false;
@@ -899,6 +924,7 @@ export class UppHelpersC extends UppHelpersBase<CNodeTypes> {
     }
 
     this.registry.registerPendingRule({
+      description: this.describesRules ? `withExpressionType(${typeof targetType === 'string' ? targetType : targetType.text.split('\n')[0]})` : undefined,
       matcher: (node, helpers) => {
         // Only evaluate expressions and literals
         const t = node.type;
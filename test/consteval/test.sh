@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Checks which @consteval calls fold to literals, and that the folded values match the compiled functions
+upp cc fold.c -o fold
+status=0
+expect() {
+    if ! grep -qF -- "$1" fold.c; then
+        echo "FAILURE: expected '$1' in fold.c"
+        status=1
+    fi
+}
+expect 'folded_uadd = 205032704u;'
+expect 'folded_shl = 1073741824;'
+expect 'folded_shr = (-4);'
+expect 'folded_below = 0;'
+expect 'folded_lbelow = 1;'
+expect 'folded_reciprocal = 0.3333333333333333;'
+expect 'folded_tenth = 0.1f;'
+expect 'folded_sum = 55;'
+expect 'folded_sizes = 23ul;'
+expect 'kept_sum = sum_to(100);'
+expect 'kept_overflow = add(2147483647, 1);'
+expect 'kept_shift_sign = shl(1, 31);'
+expect 'kept_shift_negative = shl(-1, 1);'
+expect 'kept_shift_count = shl(1, 32);'
+
+output=$(./fold)
+expected=$'205032704 1073741824 -4 0 1 0.33333333333333331 0.100000001 55 23\n5050'
+if [ "$output" != "$expected" ]; then
+    echo "FAILURE: got"
+    echo "$output"
+    status=1
+fi
+rm -f *.c *.h fold
+exit $status
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# Races retains and releases of one @ManagedStruct(T, atomic) object across threads under ThreadSanitizer
+if [ "$(uname)" != "Linux" ]; then
+    echo "skipped: ThreadSanitizer stress test needs Linux"
+    exit 0
+fi
+
+upp cc -fsanitize=thread -pthread -g -O1 stress.c -o stress
+TSAN_OPTIONS=halt_on_error=1 ./stress
+status=$?
+rm -f *.c *.h stress
+exit $status
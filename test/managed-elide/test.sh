@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# With 'elide', only a stable local's last use may hand its reference over; a local whose address was taken keeps it
+upp cc -fsanitize=address,undefined -g last_use.c -o last_use
+status=0
+if grep -qF '_Managed_take(&kept)' last_use.c; then
+    echo "FAILURE: the last use of 'kept' was moved although its address was taken"
+    status=1
+fi
+if ! grep -qF '_Managed_take(&plain)' last_use.c; then
+    echo "FAILURE: the last use of 'plain' was not moved"
+    status=1
+fi
+
+output=$(./last_use)
+expected=$'7 1\n5 5 2'
+if [ "$output" != "$expected" ]; then
+    echo "FAILURE: got"
+    echo "$output"
+    status=1
+fi
+rm -f *.c *.h last_use
+exit $status
@@ -1,6 +1,7 @@
 import fs from 'fs';
 import path from 'path';
 import { spawnSync } from 'child_process';
+import os from 'os';
 import readline from 'readline';
 import { fileURLToPath } from 'url';
 
@@ -10,6 +11,31 @@ const __dirname = path.dirname(__filename);
 const EXAMPLES_DIR = path.join(__dirname, '../examples');
 const RESULTS_DIR = path.join(__dirname, '../test-results');
 const UPDATE_FLAG = process.argv.includes('--update');
+const PERF_FLAG = !process.argv.includes('--no-perf');
+// Kept out of test-results/ so `npm run clean` does not discard it
+const PERF_BASELINE = path.join(__dirname, 'perf-baseline.json');
+
+// Counters that only depend on the input, so any growth is a real change in the work done
+const COUNTER_TOLERANCE = 0.10;
+// Transform time excludes the C compiler and the test binary but is still noisy, so only flag gross regressions
+const TIME_FACTOR = 2;
+const TIME_SLACK_MS = 250;
+
+interface PerfRecord {
+    transformMs: number;
+    parses: number;
+    edits: number;
+    nodesWrapped: number;
+    walkerVisits: number;
+    matcherCalls: number;
+}
+
+const COUNTERS = ['parses', 'edits', 'nodesWrapped', 'walkerVisits', 'matcherCalls'] as const;
+
+const perfBaseline: Record<string, PerfRecord> = fs.existsSync(PERF_BASELINE)
+    ? JSON.parse(fs.readFileSync(PERF_BASELINE, 'utf8'))
+    : {};
+let perfBaselineChanged = false;
 
 if (!fs.existsSync(RESULTS_DIR)) {
     fs.mkdirSync(RESULTS_DIR, { recursive: true });
@@ -87,16 +113,73 @@ async function verifySnapshot(testName: string, actualOutput: string): Promise<b
     return true;
 }
 
+/**
+ * Reads the counters written by `upp --stats=<file>` into a PerfRecord.
+ */
+function readPerfRecord(statsPath: string): PerfRecord | null {
+    if (!fs.existsSync(statsPath)) return null;
+    const stats = JSON.parse(fs.readFileSync(statsPath, 'utf8'));
+    fs.unlinkSync(statsPath);
+    const sum = (values: any[]) => values.reduce((a: number, b: number) => a + b, 0);
+    return {
+        transformMs: stats.transformMs,
+        parses: sum(Object.values(stats.parses)),
+        edits: stats.edits,
+        nodesWrapped: stats.nodesWrapped,
+        walkerVisits: stats.walkerVisits,
+        matcherCalls: sum(Object.values(stats.rules).map((r: any) => r.matcherCalls))
+    };
+}
+
+/**
+ * Compares a test's counters and transform time against the perf baseline.
+ * A test without a baseline entry fails; --update records or refreshes it.
+ */
+function verifyPerf(testName: string, actual: PerfRecord): boolean {
+    if (UPDATE_FLAG) {
+        perfBaseline[testName] = actual;
+        perfBaselineChanged = true;
+        return true;
+    }
+    const baseline = perfBaseline[testName];
+    if (!baseline) {
+        console.log(`[FAIL] ${testName} has no entry in ${path.relative(process.cwd(), PERF_BASELINE)}; run with --update to record it.`);
+        return false;
+    }
+
+    const regressions: string[] = [];
+    for (const counter of COUNTERS) {
+        const limit = Math.floor(baseline[counter] * (1 + COUNTER_TOLERANCE));
+        if (actual[counter] > limit) {
+            const growth = baseline[counter] ? `+${(((actual[counter] - baseline[counter]) / baseline[counter]) * 100).toFixed(0)}%` : 'was 0';
+            regressions.push(`${counter} ${baseline[counter]} -> ${actual[counter]} (${growth})`);
+        }
+    }
+    const timeLimit = Math.max(baseline.transformMs * TIME_FACTOR, baseline.transformMs + TIME_SLACK_MS);
+    if (actual.transformMs > timeLimit) {
+        regressions.push(`transform time ${baseline.transformMs}ms -> ${actual.transformMs}ms`);
+    }
+
+    if (regressions.length) {
+        console.log(`[FAIL] ${testName} perf regression: ${regressions.join(', ')}`);
+        return false;
+    }
+    return true;
+}
+
 async function runTest(entryName: string): Promise<boolean> {
     const entryPath = path.join(EXAMPLES_DIR, entryName);
+    const testName = entryName.endsWith('.cup') ? entryName.slice(0, -4) : entryName;
+    const statsPath = path.join(os.tmpdir(), `upp-stats-${process.pid}-${testName}.json`);
 
     // Invoke upp --test
     // Note: We use index.ts directly here. 
     // Node 24 with --experimental-strip-types will handle it.
-    const run = spawnSync('node', ['--experimental-strip-types', 'index.ts', '--test', entryPath], { encoding: 'utf8' });
+    const run = spawnSync('node', ['--experimental-strip-types', 'index.ts', '--test', ...(PERF_FLAG ? [`--stats=${statsPath}`] : []), entryPath], { encoding: 'utf8' });
     const output = run.stdout + run.stderr;
+    // Read (and remove) the stats file before any early return
+    const perf = PERF_FLAG ? readPerfRecord(statsPath) : null;
 
-    const testName = entryName.endsWith('.cup') ? entryName.slice(0, -4) : entryName;
     const isErrorTest = testName.startsWith('error_');
 
     const hasCompilationError = output.includes('==== COMPILATION ERROR ===');
@@ -110,7 +193,8 @@ async function runTest(entryName: string): Promise<boolean> {
         return false;
     }
 
-    return await verifySnapshot(testName, output);
+    const snapshotPassed = await verifySnapshot(testName, output);
+    return (perf ? verifyPerf(testName, perf) : true) && snapshotPassed;
 }
 
 async function main() {
@@ -142,6 +226,10 @@ async function main() {
     }
 
     rl.close();
+    if (perfBaselineChanged) {
+        const sorted = Object.fromEntries(Object.entries(perfBaseline).sort(([a], [b]) => a.localeCompare(b)));
+        fs.writeFileSync(PERF_BASELINE, JSON.stringify(sorted, null, 2) + '\n');
+    }
     if (!allPassed) {
         console.log('\nSome tests failed.');
         process.exit(1);